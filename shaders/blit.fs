@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D frame;
+
+// Frames from the software renderer are stored top row first.
+void main(){
+    FragColor = vec4(texture(frame, vec2(TexCoords.x, 1.0 - TexCoords.y)).rgb, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform float amount;
+
+void main(){
+    vec3 color = texture(scene, TexCoords).rgb;
+    float luma = dot(color, vec3(0.299, 0.587, 0.114));
+    FragColor = vec4(mix(color, vec3(luma), amount), 1.0);
+}
\ No newline at end of file
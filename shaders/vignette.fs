@@ -0,0 +1,13 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform float amount;
+
+void main(){
+    vec3 color = texture(scene, TexCoords).rgb;
+    float edge = smoothstep(0.35, 0.85, distance(TexCoords, vec2(0.5)));
+    FragColor = vec4(color * (1.0 - 0.7 * edge * amount), 1.0);
+}
\ No newline at end of file
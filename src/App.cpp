@@ -1,16 +1,17 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <stb_image.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 
-#include <textRenderer.h>
-#include <shader.h>
-#include <vao.h>
+#include <glRenderer.h>
+#include <softwareRenderer.h>
 #include <game.h>
+#include <rollback.h>
+#include <frameStats.h>
+#include <audio.h>
+#include <allocCounter.h>
 
 #include <iostream>
+#include <new>
 #include <stdlib.h>
 #include <fstream>
 #include <sstream>
@@ -18,9 +19,33 @@
 #include <string>
 #include <vector>
 
+void* operator new(std::size_t size){
+    allocCounter::allocations++;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept{
+    allocCounter::allocations++;
+    return malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept{
+    allocCounter::allocations++;
+    return malloc(size ? size : 1);
+}
+void operator delete(void* p) noexcept{ free(p); }
+void operator delete[](void* p) noexcept{ free(p); }
+void operator delete(void* p, std::size_t) noexcept{ free(p); }
+void operator delete[](void* p, std::size_t) noexcept{ free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept{ free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept{ free(p); }
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_refresh_callback(GLFWwindow* window);
 void processInput(GLFWwindow* window, int key, int scancode, int action, int mods);
-unsigned int loadTexture(const char* fp);
 
 float current_opacity = 0.0;
 float deltaTime = 0.0f;	// Time between current frame and last frame
@@ -30,12 +55,44 @@ int flyUp = 0;
 int currentState = 1; //0 - Start menu, 1 - Playing, 2 - Game Over
 float GAME_SPEED = 0.002;
 
+bool raceMode = false;
+bool checkAllocs = false;
+bool softwareMode = false;
+const int ALLOC_WARMUP_FRAMES = 600;
+const int ALLOC_CHECK_FRAMES = 3000;
+uint8_t raceFlap[RACE_PLAYERS] = { 0, 0 };
+
 glm::vec3 birdCurPos = glm::vec3(0.0f);
 glm::vec3 bgCurPos = glm::vec3(0.0f);
 std::vector<glm::vec3> pipeCurPos = { glm::vec3(1.5f, 0.0f, 0.0f), glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(2.5f, 0.0f, 0.0f), glm::vec3(3.0f),
                                 glm::vec3(3.5f, 0.0f, 0.0f), glm::vec3(4.0f, 0.0f, 0.0f), glm::vec3(4.5f, 0.0f, 0.0f), glm::vec3(5.0f, 0.0f, 0.0f) };
 
-int main(){
+int main(int argc, char** argv){
+    std::string audioWavPath, screenshotPath;
+    LinkConditions link;
+    link.delayMs = 60.0f;
+    link.jitterMs = 20.0f;
+    link.lossRate = 0.05f;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--race")
+            raceMode = true;
+        else if (arg.rfind("--delay=", 0) == 0)
+            link.delayMs = std::stof(arg.substr(8));
+        else if (arg.rfind("--jitter=", 0) == 0)
+            link.jitterMs = std::stof(arg.substr(9));
+        else if (arg.rfind("--loss=", 0) == 0)
+            link.lossRate = std::stof(arg.substr(7));
+        else if (arg == "--check-allocs")
+            checkAllocs = true;
+        else if (arg.rfind("--audio-wav=", 0) == 0)
+            audioWavPath = arg.substr(12);
+        else if (arg == "--software")
+            softwareMode = true;
+        else if (arg.rfind("--screenshot=", 0) == 0)
+            screenshotPath = arg.substr(13);
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -49,6 +106,7 @@ int main(){
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)){
         std::cout << "Failed to initialize GLAD" << std::endl;
@@ -60,104 +118,182 @@ int main(){
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    Shader birdShader("shaders/bird.vs", "shaders/bird.fs");
-    Shader bgShader("shaders/bg.vs", "shaders/bg.fs");
-    Shader pipeShader("shaders/pipe.vs", "shaders/pipe.fs");
-
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    stbi_set_flip_vertically_on_load(true);
-
-    unsigned int birdTexture = loadTexture("images/flappy.png");
-    unsigned int bgTexture = loadTexture("images/city-bg-long.png");
-    unsigned int bg_koTexture = loadTexture("images/city-bg_bw.png");
-    unsigned int menuBgTexture = loadTexture("images/menu-bg.jpg");
-    unsigned int bird_koTexture = loadTexture("images/flappy_ko.png");
-    unsigned int bird_45Texture = loadTexture("images/flappy_45.png");
-    unsigned int bird_45DownTexture = loadTexture("images/flappy_45-.png");
-    unsigned int bird_DownTexture = loadTexture("images/flappy_down.png");
-    unsigned int pipeTexture = loadTexture("images/pipe.png");
-
-    birdShader.use();
-    glUniform1i(glGetUniformLocation(birdShader.ID, "birdTexture"), 0);
-    bgShader.use();
-    glUniform1i(glGetUniformLocation(bgShader.ID, "bgTexture"), 1);
-    pipeShader.use();
-    glUniform1i(glGetUniformLocation(pipeShader.ID, "pipeTexture"), 2);
-
-    float birdVertices[] = {
-        // positions          // texture coords
-         0.06f,  0.10f, 0.0f,   1.0f, 1.0f,   // top right
-         0.06f, -0.10f, 0.0f,   1.0f, 0.0f,   // bottom right
-        -0.06f, -0.10f, 0.0f,   0.0f, 0.0f,   // bottom left
-        -0.06f,  0.10f, 0.0f,   0.0f, 1.0f    // top left 
-    };
-    
-    float bgVertices[] = {
-        // positions          // texture coords
-         3.0f,  1.0f, -1.0f,   1.0f, 1.0f,   // top right
-         3.0f, -1.0f, -1.0f,   1.0f, 0.0f,   // bottom right
-        -1.0f, -1.0f, -1.0f,   0.0f, 0.0f,   // bottom left
-        -1.0f,  1.0f, -1.0f,   0.0f, 1.0f    // top left 
-    };
-
-    float pipeVertices[] = {
-        // positions          // texture coords
-         0.1f,  0.5f, 0.7f,   1.0f, 1.0f,   // top right
-         0.1f, -0.5f, 0.7f,   1.0f, 0.0f,   // bottom right
-        -0.1f, -0.5f, 0.7f,   0.0f, 0.0f,   // bottom left
-        -0.1f,  0.5f, 0.7f,   0.0f, 1.0f    // top left 
-    };
-
-    unsigned int quadIndices[] = {
-        0, 1, 3,
-        1, 2, 3
-    };
-
-    Vao birdVAO(birdVertices, quadIndices, sizeof(birdVertices), sizeof(quadIndices));
-    Vao bgVAO(bgVertices, quadIndices, sizeof(bgVertices), sizeof(quadIndices));
-    Vao pipeVAO(pipeVertices, quadIndices, sizeof(pipeVertices), sizeof(quadIndices));
-    
-    Game game(birdShader.ID, bgShader.ID, pipeShader.ID, 
-                birdTexture, bird_koTexture, bird_45DownTexture, bird_DownTexture, 
-                bgTexture, bg_koTexture, menuBgTexture, pipeTexture, 
-                birdVAO.VAO, bgVAO.VAO, pipeVAO.VAO);
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    // --software draws on the CPU at half resolution; the window is then only
+    // used to show the finished frames.
+    std::unique_ptr<GlFrameDisplay> softwareDisplay;
+    SoftwareRenderer* software = nullptr;
+    std::unique_ptr<Renderer> renderer;
+    if (softwareMode) {
+        softwareDisplay.reset(new GlFrameDisplay());
+        software = new SoftwareRenderer(SCR_WIDTH / 2, SCR_HEIGHT / 2, softwareDisplay.get());
+        renderer.reset(software);
+    }
+    else {
+        renderer.reset(new GlRenderer(framebufferWidth, framebufferHeight));
+    }
+
+    Game game(*renderer);
     game.init();
 
+    // Sound goes to the default device, or is recorded with
+    // --audio-wav=<path>. With neither there is nothing to mix for, so no
+    // mixer thread is started.
+    std::unique_ptr<AudioBackend> audioBackend;
+    if (audioWavPath.empty())
+        audioBackend = openAudioDevice();
+    else
+        audioBackend.reset(new WavFileBackend(audioWavPath));
+    std::unique_ptr<AudioMixer> audio;
+    if (audioBackend) {
+        audio.reset(new AudioMixer(*audioBackend));
+        game.setAudio(audio.get());
+    }
+    else {
+        std::cout << "AUDIO: No sound device, playing without sound" << std::endl;
+    }
+
     glfwSetWindowUserPointer(window, &game);
-    TextRenderer textRenderer("fonts/blocks.ttf", "shaders/text.vs", "shaders/text.fs", 0, 48);
+    int scoreFont = renderer->loadFont("fonts/blocks.ttf", 48);
+
+    // Race mode runs both peers in this process over a lossy loopback link:
+    // SPACE flaps player 1, UP flaps player 2, and player 1's view is shown.
+    std::unique_ptr<LoopbackTransport> raceLinks[RACE_PLAYERS];
+    std::unique_ptr<RollbackSession> racePeers[RACE_PLAYERS];
+    if (raceMode) {
+        LoopbackTransport::createPair(link, raceLinks[0], raceLinks[1]);
+        uint32_t seed = (uint32_t)rand();
+        for (int i = 0; i < RACE_PLAYERS; i++)
+            racePeers[i].reset(new RollbackSession(*raceLinks[i], i, seed));
+    }
+
+    FrameStats frameStats("MENU", "PLAYING", "GAME_OVER");
+    double wakeAt = 0.0;
+    bool wakeOnInputOnly = false;
+
+    // --check-allocs runs the attract-mode demo and fails if any frame after
+    // warm-up allocates from the heap.
+    int checkedFrames = 0, allocatingFrames = 0;
+    if (checkAllocs)
+        game.startAttract();
 
     while (!glfwWindowShouldClose(window)){
-        glClearColor(0.2f, 0.3f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        frameStats.sample(raceMode ? PLAYING : game.curGameState, renderer->workerCpuSeconds());
+
+        // Static screens are presented once, then the loop sleeps until input
+        // arrives or the next timed transition is due.
+        if (!raceMode && game.isStatic() && !game.isDirty()) {
+            if (wakeOnInputOnly) {
+                glfwWaitEvents();
+                continue;
+            }
+            double timeout = wakeAt - glfwGetTime();
+            if (timeout > 0.0) {
+                glfwWaitEventsTimeout(timeout);
+                continue;
+            }
+        }
+
+        unsigned long long allocsBefore = allocCounter::count();
+        frameStats.beginFrame();
+        game.beginFrame();
+        renderer->clear(glm::vec3(0.2f, 0.3f, 1.0f));
 
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        game.run(deltaTime);
+        if (raceMode) {
+            for (int i = 0; i < RACE_PLAYERS; i++) {
+                if (racePeers[i]->advance(raceFlap[i]))
+                    raceFlap[i] = 0;
+            }
+            const RaceState& race = racePeers[0]->state();
+            game.runRace(race, 0);
+            renderer->drawText(scoreFont, game.getFrameArena().format("P1: %u  P2: %u", race.birds[0].score, race.birds[1].score), 25.0f, 1000.0f, 1.0f, glm::vec3(0.8, 0.2f, 0.4f));
+        }
+        else {
+            game.run(deltaTime);
 
-        textRenderer.RenderText("Score: " + std::to_string(game.getScore()), 25.0f, 1000.0f, 1.0f, glm::vec3(0.8, 0.2f, 0.4f));
+            renderer->drawText(scoreFont, game.getFrameArena().format("Score: %d", game.getScore()), 25.0f, 1000.0f, 1.0f, glm::vec3(0.8, 0.2f, 0.4f));
+        }
 
+        renderer->present();
+        frameStats.endFrame();
         glfwSwapBuffers(window);
         glfwPollEvents();
+        double wakeTimeout = game.wakeTimeout();
+        wakeOnInputOnly = wakeTimeout < 0.0;
+        wakeAt = lastFrame + wakeTimeout;
+
+        if (checkAllocs) {
+            unsigned long long allocs = allocCounter::count() - allocsBefore;
+            if (checkedFrames >= ALLOC_WARMUP_FRAMES && allocs > 0) {
+                allocatingFrames++;
+                std::cout << "ALLOC::FRAME " << checkedFrames << ": " << allocs << " heap allocations" << std::endl;
+            }
+            if (++checkedFrames == ALLOC_WARMUP_FRAMES + ALLOC_CHECK_FRAMES)
+                glfwSetWindowShouldClose(window, true);
+        }
     }
 
-    glDeleteVertexArrays(1, &birdVAO.VAO);
-    glDeleteVertexArrays(1, &bgVAO.VAO);
-    glDeleteVertexArrays(1, &pipeVAO.VAO);
+    frameStats.sample(game.curGameState);
+    frameStats.report(std::cout);
+
+    if (audio) {
+        audio->stop();
+        game.setAudio(nullptr);
+        AudioStats audioStats = audio->getStats();
+        std::cout << "AUDIO: " << audioStats.periods << " periods, mix avg " << (audioStats.periods ? audioStats.totalMixMicros / audioStats.periods : 0.0)
+            << "us, max " << audioStats.maxMixMicros << "us, max event latency " << audioStats.maxEventLatencyMicros
+            << "us, underruns " << audioStats.underruns << ", dropped " << audioStats.droppedEvents << std::endl;
+    }
 
+    if (raceMode) {
+        for (int i = 0; i < RACE_PLAYERS; i++) {
+            const RollbackStats& stats = racePeers[i]->getStats();
+            std::cout << "ROLLBACK::P" << (i + 1) << ": rollbacks " << stats.rollbacks << ", max depth " << stats.maxDepth
+                << ", max resim " << stats.maxResimMicros << "us, stalls " << stats.stalls << std::endl;
+        }
+    }
+
+    if (!screenshotPath.empty()) {
+        if (software)
+            software->saveScreenshot(screenshotPath.c_str());
+        else
+            std::cout << "ERROR::SCREENSHOT: --screenshot needs --software" << std::endl;
+    }
+
+    // GL objects have to go before the context does.
+    renderer.reset();
+    softwareDisplay.reset();
     glfwTerminate();
+    if (checkAllocs) {
+        std::cout << "ALLOC: " << allocatingFrames << " of " << ALLOC_CHECK_FRAMES << " steady-state frames allocated" << std::endl;
+        return allocatingFrames > 0 ? 1 : 0;
+    }
     return 0;
 }
 
 void processInput(GLFWwindow* window, int key, int scancode, int action, int mods){
     Game* game = static_cast<Game*>(glfwGetWindowUserPointer(window));
+    game->markDirty();
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    else if (action == GLFW_PRESS && game->wake())
+        return;
+    else if (raceMode) {
+        if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
+            raceFlap[0] = 1;
+        else if (key == GLFW_KEY_UP && action == GLFW_PRESS)
+            raceFlap[1] = 1;
+    }
     else if (key == GLFW_KEY_SPACE && action != GLFW_RELEASE) {
-        game->fallPoint = game->birdCurPos.y;
-        game->flyUpCount += 25;
+        game->flap();
     }
     else if (key == GLFW_KEY_RIGHT && action != GLFW_RELEASE) {
         if (game->curGameState == MENU) {
@@ -189,38 +325,14 @@ void processInput(GLFWwindow* window, int key, int scancode, int action, int mod
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height){
     glViewport(0, 0, width, height);
+    Game* game = static_cast<Game*>(glfwGetWindowUserPointer(window));
+    if (game)
+        game->resize(width, height);
+    window_refresh_callback(window);
 }
 
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
\ No newline at end of file
+void window_refresh_callback(GLFWwindow* window){
+    Game* game = static_cast<Game*>(glfwGetWindowUserPointer(window));
+    if (game)
+        game->markDirty();
+}
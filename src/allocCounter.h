@@ -0,0 +1,14 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+// Counts heap allocations made by the current thread through operator new.
+// The replacement operators that bump the counter are defined in App.cpp.
+namespace allocCounter {
+    inline thread_local unsigned long long allocations = 0;
+
+    inline unsigned long long count() {
+        return allocations;
+    }
+}
+
+#endif
@@ -0,0 +1,442 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <spscQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AUDIO_SSE 1
+#endif
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+enum Sounds { SOUND_FLAP, SOUND_SCORE, SOUND_CRASH, SOUND_COUNT };
+
+const int AUDIO_SAMPLE_RATE = 48000;
+const int AUDIO_MAX_PERIOD = 1024;
+const int AUDIO_MAX_VOICES = 16;
+const int WAVEOUT_BUFFERS = 8;
+
+struct AudioEvent {
+    int sound;
+    float gain;
+    std::chrono::steady_clock::time_point queuedAt;
+};
+
+struct AudioStats {
+    unsigned long long periods = 0;
+    unsigned long long underruns = 0;
+    unsigned long long droppedEvents = 0;
+    double lastMixMicros = 0.0;
+    double maxMixMicros = 0.0;
+    double totalMixMicros = 0.0;
+    double maxEventLatencyMicros = 0.0;
+};
+
+inline void toPcm16(const float* samples, int16_t* pcm, int count) {
+    for (int i = 0; i < count; i++)
+        pcm[i] = (int16_t)std::lround(samples[i] * 32767.0f);
+}
+
+// Destination for mixed mono float samples. Backends without a device clock
+// let the mixer pace itself in real time.
+class AudioBackend {
+    public:
+        virtual ~AudioBackend() {}
+        virtual void write(const float* samples, int count) = 0;
+        // True if write() waits for the device, which then sets the pace.
+        virtual bool pacesItself() const { return false; }
+};
+
+class NullAudioBackend : public AudioBackend {
+    public:
+        void write(const float*, int) override {}
+};
+
+// Writes everything the mixer produces to a 16-bit mono WAV file.
+class WavFileBackend : public AudioBackend {
+    FILE* file;
+    uint32_t dataBytes;
+    int16_t pcm[AUDIO_MAX_PERIOD];
+
+    void writeHeader() {
+        uint32_t byteRate = AUDIO_SAMPLE_RATE * 2;
+        uint32_t riffSize = 36 + dataBytes;
+        uint32_t fmtSize = 16, sampleRate = AUDIO_SAMPLE_RATE;
+        uint16_t format = 1, channels = 1, blockAlign = 2, bits = 16;
+        fseek(file, 0, SEEK_SET);
+        fwrite("RIFF", 1, 4, file);
+        fwrite(&riffSize, 4, 1, file);
+        fwrite("WAVEfmt ", 1, 8, file);
+        fwrite(&fmtSize, 4, 1, file);
+        fwrite(&format, 2, 1, file);
+        fwrite(&channels, 2, 1, file);
+        fwrite(&sampleRate, 4, 1, file);
+        fwrite(&byteRate, 4, 1, file);
+        fwrite(&blockAlign, 2, 1, file);
+        fwrite(&bits, 2, 1, file);
+        fwrite("data", 1, 4, file);
+        fwrite(&dataBytes, 4, 1, file);
+    }
+
+    public:
+        WavFileBackend(const std::string& path) : dataBytes(0) {
+            file = fopen(path.c_str(), "wb");
+            if (!file) {
+                std::cout << "ERROR::AUDIO: Failed to open " << path << std::endl;
+                return;
+            }
+            writeHeader();
+        }
+
+        ~WavFileBackend() {
+            if (!file)
+                return;
+            writeHeader();
+            fclose(file);
+        }
+
+        void write(const float* samples, int count) override {
+            if (!file)
+                return;
+            toPcm16(samples, pcm, count);
+            fwrite(pcm, sizeof(int16_t), count, file);
+            dataBytes += count * sizeof(int16_t);
+        }
+};
+
+#ifdef _WIN32
+// Plays through the default sound device with WinMM. write() waits until one
+// of a few small buffers has come back from the device, so the device clock
+// paces the mixer and latency stays at WAVEOUT_BUFFERS periods.
+class WaveOutBackend : public AudioBackend {
+    HWAVEOUT device;
+    HANDLE bufferDone;
+    WAVEHDR headers[WAVEOUT_BUFFERS];
+    int16_t pcm[WAVEOUT_BUFFERS][AUDIO_MAX_PERIOD];
+    int next;
+    bool open;
+
+    public:
+        WaveOutBackend() : device(NULL), next(0), open(false) {
+            bufferDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+            WAVEFORMATEX format = {};
+            format.wFormatTag = WAVE_FORMAT_PCM;
+            format.nChannels = 1;
+            format.nSamplesPerSec = AUDIO_SAMPLE_RATE;
+            format.wBitsPerSample = 16;
+            format.nBlockAlign = 2;
+            format.nAvgBytesPerSec = AUDIO_SAMPLE_RATE * 2;
+            if (waveOutOpen(&device, WAVE_MAPPER, &format, (DWORD_PTR)bufferDone, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+                std::cout << "ERROR::AUDIO: Failed to open the sound device" << std::endl;
+                return;
+            }
+            open = true;
+            for (int i = 0; i < WAVEOUT_BUFFERS; i++) {
+                headers[i] = WAVEHDR();
+                headers[i].dwFlags = WHDR_DONE;
+            }
+        }
+
+        WaveOutBackend(const WaveOutBackend&) = delete;
+        WaveOutBackend& operator=(const WaveOutBackend&) = delete;
+
+        ~WaveOutBackend() {
+            if (open) {
+                waveOutReset(device);
+                for (int i = 0; i < WAVEOUT_BUFFERS; i++)
+                    if (headers[i].dwFlags & WHDR_PREPARED)
+                        waveOutUnprepareHeader(device, &headers[i], sizeof(WAVEHDR));
+                waveOutClose(device);
+            }
+            CloseHandle(bufferDone);
+        }
+
+        bool isOpen() const {
+            return open;
+        }
+
+        bool pacesItself() const override {
+            return open;
+        }
+
+        void write(const float* samples, int count) override {
+            if (!open)
+                return;
+            WAVEHDR& header = headers[next];
+            while (!(header.dwFlags & WHDR_DONE))
+                WaitForSingleObject(bufferDone, INFINITE);
+            if (header.dwFlags & WHDR_PREPARED)
+                waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+
+            toPcm16(samples, pcm[next], count);
+            header = WAVEHDR();
+            header.lpData = (LPSTR)pcm[next];
+            header.dwBufferLength = count * sizeof(int16_t);
+            waveOutPrepareHeader(device, &header, sizeof(WAVEHDR));
+            waveOutWrite(device, &header, sizeof(WAVEHDR));
+            next = (next + 1) % WAVEOUT_BUFFERS;
+        }
+};
+#endif
+
+// The platform's sound device, or nullptr if there is none to open.
+inline std::unique_ptr<AudioBackend> openAudioDevice() {
+#ifdef _WIN32
+    std::unique_ptr<WaveOutBackend> device(new WaveOutBackend());
+    if (device->isOpen())
+        return std::move(device);
+#endif
+    return nullptr;
+}
+
+// dst[i] += src[i] * gain
+inline void mixAdd(float* dst, const float* src, float gain, int count) {
+    int i = 0;
+#ifdef AUDIO_SSE
+    __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#endif
+    for (; i < count; i++)
+        dst[i] += src[i] * gain;
+}
+
+inline void clipSamples(float* samples, int count) {
+    int i = 0;
+#ifdef AUDIO_SSE
+    __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lo), hi));
+#endif
+    for (; i < count; i++)
+        samples[i] = std::min(std::max(samples[i], -1.0f), 1.0f);
+}
+
+// Mixes preloaded PCM voices on its own high-priority thread. The frame
+// thread only pushes trigger events onto a lock-free queue, so playing a
+// sound never adds work or blocking to a frame. Output is produced in small
+// fixed periods to keep trigger-to-speaker latency low. When nothing is
+// playing the thread parks until the next trigger, so a quiet game costs no
+// wakeups. A backend without its own clock, such as a WAV file, is then given
+// the time spent parked as silence, so a recording keeps real timing.
+class AudioMixer {
+    struct Voice {
+        int sound;
+        int position;
+        float gain;
+    };
+
+    AudioBackend& backend;
+    int periodFrames;
+    bool paced;
+    std::vector<float> sounds[SOUND_COUNT];
+    Voice voices[AUDIO_MAX_VOICES];
+    int activeVoices;
+    alignas(16) float mixBuffer[AUDIO_MAX_PERIOD];
+
+    SpscQueue<AudioEvent, 64> events;
+    std::atomic<bool> running;
+    std::atomic<unsigned long long> dropped;
+    std::mutex wakeMutex;
+    std::condition_variable wakeMixer;
+    AudioStats stats;
+    std::thread mixer;
+
+    static std::vector<float> tone(float seconds, float startHz, float endHz, float decay) {
+        std::vector<float> out((std::size_t)(seconds * AUDIO_SAMPLE_RATE));
+        double phase = 0.0;
+        for (std::size_t i = 0; i < out.size(); i++) {
+            float t = (float)i / out.size();
+            phase += 2.0 * 3.14159265358979 * (startHz + (endHz - startHz) * t) / AUDIO_SAMPLE_RATE;
+            out[i] = (float)std::sin(phase) * std::exp(-decay * t) * 0.5f;
+        }
+        return out;
+    }
+
+    void synthesize() {
+        sounds[SOUND_FLAP] = tone(0.08f, 600.0f, 1200.0f, 4.0f);
+
+        std::vector<float> high = tone(0.06f, 1320.0f, 1320.0f, 2.0f);
+        sounds[SOUND_SCORE] = tone(0.06f, 880.0f, 880.0f, 2.0f);
+        sounds[SOUND_SCORE].insert(sounds[SOUND_SCORE].end(), high.begin(), high.end());
+
+        std::vector<float>& crash = sounds[SOUND_CRASH];
+        crash.resize((std::size_t)(0.3f * AUDIO_SAMPLE_RATE));
+        uint32_t noise = 0x12345678u;
+        float filtered = 0.0f;
+        for (std::size_t i = 0; i < crash.size(); i++) {
+            noise = noise * 1664525u + 1013904223u;
+            float white = (noise >> 8) / 8388608.0f - 1.0f;
+            filtered += 0.1f * (white - filtered);
+            crash[i] = filtered * std::exp(-5.0f * i / crash.size()) * 1.5f;
+        }
+    }
+
+    static void raisePriority() {
+#ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+        sched_param param;
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+    }
+
+    void start(const AudioEvent& event) {
+        if (event.sound < 0 || event.sound >= SOUND_COUNT)
+            return;
+        int slot = activeVoices;
+        if (activeVoices < AUDIO_MAX_VOICES) {
+            activeVoices++;
+        }
+        else {
+            slot = 0;
+            for (int v = 1; v < AUDIO_MAX_VOICES; v++)
+                if (voices[v].position > voices[slot].position)
+                    slot = v;
+        }
+        voices[slot] = { event.sound, 0, event.gain };
+    }
+
+    void mixPeriod() {
+        auto begin = std::chrono::steady_clock::now();
+
+        AudioEvent event;
+        while (events.pop(event)) {
+            start(event);
+            double latency = std::chrono::duration<double, std::micro>(begin - event.queuedAt).count();
+            stats.maxEventLatencyMicros = std::max(stats.maxEventLatencyMicros, latency);
+        }
+
+        std::fill(mixBuffer, mixBuffer + periodFrames, 0.0f);
+        for (int v = 0; v < activeVoices;) {
+            Voice& voice = voices[v];
+            const std::vector<float>& pcm = sounds[voice.sound];
+            int count = std::min(periodFrames, (int)pcm.size() - voice.position);
+            mixAdd(mixBuffer, pcm.data() + voice.position, voice.gain, count);
+            voice.position += count;
+            if (voice.position >= (int)pcm.size())
+                voices[v] = voices[--activeVoices];
+            else
+                v++;
+        }
+        clipSamples(mixBuffer, periodFrames);
+        backend.write(mixBuffer, periodFrames);
+
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        stats.periods++;
+        stats.lastMixMicros = micros;
+        stats.totalMixMicros += micros;
+        stats.maxMixMicros = std::max(stats.maxMixMicros, micros);
+    }
+
+    void run() {
+        raisePriority();
+        auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>((double)periodFrames / AUDIO_SAMPLE_RATE));
+        bool selfPaced = paced && !backend.pacesItself();
+        auto deadline = std::chrono::steady_clock::now();
+        while (running.load(std::memory_order_acquire)) {
+            if (activeVoices == 0 && events.empty()) {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeMixer.wait(lock, [&] { return !running.load(std::memory_order_acquire) || !events.empty(); });
+                lock.unlock();
+                auto now = std::chrono::steady_clock::now();
+                if (!selfPaced) {
+                    deadline = now;
+                    continue;
+                }
+                std::fill(mixBuffer, mixBuffer + periodFrames, 0.0f);
+                for (; deadline + period <= now; deadline += period)
+                    backend.write(mixBuffer, periodFrames);
+                continue;
+            }
+            mixPeriod();
+            if (!selfPaced)
+                continue;
+            deadline += period;
+            auto now = std::chrono::steady_clock::now();
+            if (now > deadline + period) {
+                stats.underruns++;
+                deadline = now;
+            }
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+    public:
+        // paced = false mixes as fast as possible, for throughput tests.
+        AudioMixer(AudioBackend& backend, int periodFrames = 128, bool paced = true)
+            : backend(backend), periodFrames(std::min(std::max(periodFrames, 4), AUDIO_MAX_PERIOD)), paced(paced), activeVoices(0), running(true), dropped(0) {
+            synthesize();
+            mixer = std::thread(&AudioMixer::run, this);
+        }
+
+        AudioMixer(const AudioMixer&) = delete;
+        AudioMixer& operator=(const AudioMixer&) = delete;
+
+        ~AudioMixer() {
+            stop();
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                running.store(false, std::memory_order_release);
+            }
+            wakeMixer.notify_one();
+            if (mixer.joinable())
+                mixer.join();
+        }
+
+        // Safe to call from the frame thread only. Never waits on mixing; the
+        // lock only guards the mixer's check before it parks.
+        bool trigger(int sound, float gain = 1.0f) {
+            if (events.push({ sound, gain, std::chrono::steady_clock::now() })) {
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                }
+                wakeMixer.notify_one();
+                return true;
+            }
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Only valid once stop() has returned.
+        AudioStats getStats() const {
+            AudioStats result = stats;
+            result.droppedEvents = dropped.load(std::memory_order_relaxed);
+            return result;
+        }
+};
+
+#endif
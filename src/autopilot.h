@@ -0,0 +1,267 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <simulation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+const unsigned int AUTOPILOT_STEP_TICKS = 20;
+const int AUTOPILOT_MAX_NODES = 1 << 14;
+const double AUTOPILOT_DEFAULT_BUDGET_US = 500.0;
+
+struct AutopilotStats {
+    uint32_t nodesSearched = 0;
+    uint32_t maxDepth = 0;
+    double decisionMicros = 0.0;
+    double maxDecisionMicros = 0.0;
+};
+
+// Plays the game by searching flap/no-flap sequences ahead of the bird. A
+// decision is made every AUTOPILOT_STEP_TICKS ticks; each node of the tree is
+// the state one decision later, simulated with the same rules as play.
+//
+// The search is anytime: think() expands nodes breadth-first until its
+// per-frame budget runs out and keeps the tree between frames. After a
+// decision the chosen child becomes the new root, so the work spent on
+// that branch carries over. Node values are kept up to date as the tree
+// grows and discarded branches are recycled lazily, so a decision costs the
+// same as any other frame.
+class Autopilot {
+    struct Node {
+        WorldState world;
+        BirdState bird;
+        double value;
+        int parent;
+        int children[2];
+        uint32_t generation;
+        uint32_t depth;
+        bool dead;
+    };
+
+    struct FrontierEntry {
+        int node;
+        uint32_t generation;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    std::vector<int> garbage;
+    std::vector<FrontierEntry> frontier;
+    std::size_t frontierHead = 0, frontierSize = 0;
+
+    int root = -1;
+    unsigned int ticksToDecision = 0;
+    double budgetMicros;
+    AutopilotStats stats;
+
+    int allocate() {
+        int index;
+        if (!freeNodes.empty()) {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else if (!garbage.empty()) {
+            index = garbage.back();
+            garbage.pop_back();
+            for (int child : nodes[index].children) {
+                if (child >= 0) {
+                    nodes[child].parent = -1;
+                    garbage.push_back(child);
+                }
+            }
+        }
+        else {
+            return -1;
+        }
+        Node& node = nodes[index];
+        node.generation++;
+        node.children[0] = node.children[1] = -1;
+        node.dead = false;
+        return index;
+    }
+
+    // Detaches a subtree; its nodes are reclaimed one at a time by allocate().
+    void discard(int subtree) {
+        nodes[subtree].parent = -1;
+        nodes[subtree].generation++;
+        garbage.push_back(subtree);
+    }
+
+    bool inTree(int index) const {
+        while (nodes[index].parent >= 0)
+            index = nodes[index].parent;
+        return index == root;
+    }
+
+    void enqueue(int index) {
+        if (frontierSize == frontier.size())
+            return;
+        frontier[(frontierHead + frontierSize) % frontier.size()] = { index, nodes[index].generation };
+        frontierSize++;
+    }
+
+    // Surviving deeper always wins; among equally deep lines the one that
+    // ends closest to the centre of the next gap is preferred.
+    static double leafValue(const Node& node) {
+        if (node.dead)
+            return node.depth * 1000.0 - 100000.0;
+
+        float nextGap = 0.0f, nextX = 1e30f;
+        for (const auto& pipe : node.world.pipeCurPos) {
+            if (pipe.x > -0.1f && pipe.x < nextX) {
+                nextX = pipe.x;
+                nextGap = 0.75f - pipe.y;
+            }
+        }
+        return node.depth * 1000.0 - std::abs(node.bird.pos.y - nextGap) * 100.0;
+    }
+
+    void resetTree(const WorldState& world, const BirdState& bird) {
+        if (root >= 0)
+            discard(root);
+        frontierHead = frontierSize = 0;
+        root = allocate();
+        Node& node = nodes[root];
+        node.world = world;
+        node.bird = bird;
+        node.parent = -1;
+        node.depth = 0;
+        node.value = leafValue(node);
+        enqueue(root);
+    }
+
+    bool expand(int index) {
+        int children[2];
+        for (int action = 0; action < 2; action++) {
+            children[action] = allocate();
+            if (children[action] < 0) {
+                if (action)
+                    freeNodes.push_back(children[0]);
+                return false;
+            }
+        }
+
+        for (int action = 0; action < 2; action++) {
+            Node& node = nodes[children[action]];
+            node.world = nodes[index].world;
+            node.bird = nodes[index].bird;
+            node.parent = index;
+            node.depth = nodes[index].depth + 1;
+            if (action)
+                flap(node.bird);
+            for (unsigned int t = 0; t < AUTOPILOT_STEP_TICKS && !node.dead; t++)
+                node.dead = stepPlaying(node.world, node.bird, SIM_DELTA);
+            node.value = leafValue(node);
+            nodes[index].children[action] = children[action];
+            if (!node.dead)
+                enqueue(children[action]);
+        }
+        stats.maxDepth = std::max(stats.maxDepth, nodes[index].depth + 1 - nodes[root].depth);
+
+        for (int i = index; i >= 0; i = nodes[i].parent) {
+            double value = std::max(nodes[nodes[i].children[0]].value, nodes[nodes[i].children[1]].value);
+            if (value == nodes[i].value && i != index)
+                break;
+            nodes[i].value = value;
+        }
+        return true;
+    }
+
+    void search(std::chrono::steady_clock::time_point deadline) {
+        while (frontierSize > 0) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+            FrontierEntry entry = frontier[frontierHead];
+            if (nodes[entry.node].generation == entry.generation && inTree(entry.node)) {
+                if (!expand(entry.node))
+                    break;
+                stats.nodesSearched++;
+            }
+            frontierHead = (frontierHead + 1) % frontier.size();
+            frontierSize--;
+        }
+    }
+
+    public:
+        Autopilot(double budgetMicros = AUTOPILOT_DEFAULT_BUDGET_US) : budgetMicros(budgetMicros) {
+            nodes.resize(AUTOPILOT_MAX_NODES);
+            freeNodes.reserve(AUTOPILOT_MAX_NODES);
+            for (int i = AUTOPILOT_MAX_NODES - 1; i >= 0; i--)
+                freeNodes.push_back(i);
+            garbage.reserve(AUTOPILOT_MAX_NODES);
+            frontier.resize(2 * AUTOPILOT_MAX_NODES);
+        }
+
+        void setBudget(double micros) {
+            budgetMicros = micros;
+        }
+
+        void reset() {
+            if (root >= 0)
+                discard(root);
+            root = -1;
+            frontierHead = frontierSize = 0;
+            ticksToDecision = 0;
+            stats = AutopilotStats();
+        }
+
+        // Called once per tick before the game steps. Returns true when the
+        // bird should flap this tick.
+        bool think(const WorldState& world, const BirdState& bird) {
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::micro>(budgetMicros));
+            stats.nodesSearched = 0;
+            stats.maxDepth = 0;
+
+            bool flapNow = false;
+            if (ticksToDecision == 0) {
+                if (root < 0 || std::memcmp(&nodes[root].world, &world, sizeof(world)) != 0 || std::memcmp(&nodes[root].bird, &bird, sizeof(bird)) != 0)
+                    resetTree(world, bird);
+                search(deadline);
+
+                Node& node = nodes[root];
+                if (node.children[0] >= 0)
+                    flapNow = nodes[node.children[1]].value > nodes[node.children[0]].value;
+                else
+                    flapNow = bird.flyUpCount == 0 && bird.pos.y < 0.0f;
+
+                int next = node.children[flapNow ? 1 : 0];
+                int other = node.children[flapNow ? 0 : 1];
+                node.children[0] = node.children[1] = -1;
+                discard(root);
+                root = -1;
+                if (other >= 0)
+                    discard(other);
+                if (next >= 0) {
+                    if (nodes[next].dead) {
+                        discard(next);
+                    }
+                    else {
+                        root = next;
+                        nodes[root].parent = -1;
+                    }
+                }
+                ticksToDecision = AUTOPILOT_STEP_TICKS - 1;
+            }
+            else {
+                ticksToDecision--;
+                if (root >= 0)
+                    search(deadline);
+            }
+
+            stats.decisionMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            stats.maxDecisionMicros = std::max(stats.maxDecisionMicros, stats.decisionMicros);
+            return flapNow;
+        }
+
+        const AutopilotStats& getStats() const {
+            return stats;
+        }
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CPU_TIME_H
+#define CPU_TIME_H
+
+#include <ctime>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+// CPU time used by the calling thread alone. std::clock() is wall time on
+// MSVC and covers every thread in the process elsewhere.
+inline double threadCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user))
+        return 0.0;
+    unsigned long long k = ((unsigned long long)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    unsigned long long u = ((unsigned long long)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) * 1e-7;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include <flappysim.h>
+#include <simulation.h>
+#include <workerPool.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Work is split in multiples of this many environments so no two threads
+// write to the same cache line of the dones buffer.
+const int ENV_CHUNK_ALIGN = 64;
+
+struct Env {
+    WorldState world;
+    BirdState bird;
+};
+
+uint32_t mixSeed(uint32_t x) {
+    x += 0x9E3779B9u;
+    x = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+    x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+    return x ^ (x >> 16);
+}
+
+void resetEnv(Env& env, uint32_t seed) {
+    resetWorld(env.world, seed);
+    resetBird(env.bird);
+}
+
+void observe(const Env& env, float* out) {
+    float nextX = 1e30f, nextGap = 0.0f, afterX = 1e30f, afterGap = 0.0f;
+    for (const auto& pipe : env.world.pipeCurPos) {
+        if (pipe.x <= -0.1f)
+            continue;
+        if (pipe.x < nextX) {
+            afterX = nextX;
+            afterGap = nextGap;
+            nextX = pipe.x;
+            nextGap = 0.75f - pipe.y;
+        }
+        else if (pipe.x < afterX) {
+            afterX = pipe.x;
+            afterGap = 0.75f - pipe.y;
+        }
+    }
+    out[0] = env.bird.pos.y;
+    out[1] = (float)env.bird.flyUpCount / FLAP_TICKS;
+    out[2] = nextX;
+    out[3] = nextGap;
+    out[4] = afterX;
+    out[5] = afterGap;
+}
+
+}
+
+struct FlappySim {
+    std::vector<Env> envs;
+    int chunk;
+
+    const uint8_t* actions;
+    float* observations;
+    float* rewards;
+    uint8_t* dones;
+
+    // One thread per chunk of environments.
+    WorkerPool pool;
+
+    explicit FlappySim(int parts) : pool(parts) {}
+
+    void stepRange(int part) {
+        int begin = part * chunk;
+        int end = std::min(begin + chunk, (int)envs.size());
+        for (int i = begin; i < end; i++) {
+            Env& env = envs[i];
+            if (actions[i])
+                flap(env.bird);
+            unsigned int score = env.bird.score;
+            bool crashed = stepPlaying(env.world, env.bird, SIM_DELTA);
+            rewards[i] = (float)(env.bird.score - score) - (crashed ? 1.0f : 0.0f);
+            dones[i] = crashed;
+            if (crashed)
+                resetEnv(env, nextRandom(env.world.rng));
+            observe(env, observations + i * FLAPPYSIM_OBS_SIZE);
+        }
+    }
+};
+
+extern "C" {
+
+FlappySim* flappysim_create(int num_envs, uint32_t seed, int num_threads) {
+    if (num_envs <= 0)
+        return nullptr;
+    int threads = std::max(num_threads, 1);
+    int perThread = (num_envs + threads - 1) / threads;
+    int chunk = (perThread + ENV_CHUNK_ALIGN - 1) / ENV_CHUNK_ALIGN * ENV_CHUNK_ALIGN;
+
+    // Nothing may throw across the C ABI; running out of memory or threads
+    // is reported as NULL.
+    FlappySim* sim = nullptr;
+    try {
+        sim = new FlappySim((num_envs + chunk - 1) / chunk);
+        sim->chunk = chunk;
+        sim->envs.resize(num_envs);
+    }
+    catch (...) {
+        delete sim;
+        return nullptr;
+    }
+    for (int i = 0; i < num_envs; i++)
+        resetEnv(sim->envs[i], mixSeed(seed + (uint32_t)i));
+    return sim;
+}
+
+void flappysim_destroy(FlappySim* sim) {
+    delete sim;
+}
+
+int flappysim_num_envs(const FlappySim* sim) {
+    return (int)sim->envs.size();
+}
+
+void flappysim_reset(FlappySim* sim, float* observations) {
+    for (std::size_t i = 0; i < sim->envs.size(); i++) {
+        Env& env = sim->envs[i];
+        resetEnv(env, nextRandom(env.world.rng));
+        observe(env, observations + i * FLAPPYSIM_OBS_SIZE);
+    }
+}
+
+void flappysim_step(FlappySim* sim, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+    sim->actions = actions;
+    sim->observations = observations;
+    sim->rewards = rewards;
+    sim->dones = dones;
+    sim->pool.run([sim](int part) { sim->stepRange(part); });
+}
+
+}
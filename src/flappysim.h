@@ -0,0 +1,65 @@
+#ifndef FLAPPYSIM_H
+#define FLAPPYSIM_H
+
+/*
+ * libflappysim: batches of headless Flappy-GL games behind a C ABI, for
+ * training agents from C or Python. Every environment runs the same rules
+ * as the game (simulation.h), one SIM_DELTA tick per step.
+ *
+ * All buffers are owned by the caller and written in place:
+ *   actions      num_envs bytes, nonzero flaps
+ *   observations num_envs * FLAPPYSIM_OBS_SIZE floats
+ *   rewards      num_envs floats
+ *   dones        num_envs bytes
+ *
+ * An environment that crashes reports done = 1 and is reset in the same
+ * step, so its observation is already the first one of the next episode.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(FLAPPYSIM_BUILD)
+#define FLAPPYSIM_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define FLAPPYSIM_API __declspec(dllimport)
+#else
+#define FLAPPYSIM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Observation layout, all in normalized device coordinates:
+ *   0 bird height
+ *   1 flap ticks left, as a fraction of one flap
+ *   2 horizontal distance to the next pipe
+ *   3 centre of the next gap
+ *   4 horizontal distance to the pipe after it
+ *   5 centre of that gap
+ */
+#define FLAPPYSIM_OBS_SIZE 6
+
+/* Reward per step: +1 for each pipe cleared, -1 on a crash, 0 otherwise. */
+
+typedef struct FlappySim FlappySim;
+
+/*
+ * num_threads <= 1 steps on the calling thread only; 0 is treated as 1.
+ * Returns NULL if num_envs <= 0 or if the memory or threads for the batch
+ * cannot be allocated.
+ */
+FLAPPYSIM_API FlappySim* flappysim_create(int num_envs, uint32_t seed, int num_threads);
+FLAPPYSIM_API void flappysim_destroy(FlappySim* sim);
+FLAPPYSIM_API int flappysim_num_envs(const FlappySim* sim);
+
+/* Starts a new episode in every environment. */
+FLAPPYSIM_API void flappysim_reset(FlappySim* sim, float* observations);
+FLAPPYSIM_API void flappysim_step(FlappySim* sim, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string_view>
+
+// Bump allocator for data that only lives until the end of the frame, such
+// as formatted text. The buffer is allocated once; reset() at the start of
+// every frame makes the whole capacity available again.
+class FrameArena {
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity, used;
+
+    public:
+        FrameArena(std::size_t capacity) : buffer(new char[capacity]), capacity(capacity), used(0) {}
+
+        void reset() {
+            used = 0;
+        }
+
+        // Returns nullptr once the arena is exhausted.
+        void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+            std::size_t start = (used + align - 1) & ~(align - 1);
+            if (start + size > capacity)
+                return nullptr;
+            used = start + size;
+            return buffer.get() + start;
+        }
+
+        // printf-style formatting into the arena. Output that does not fit is
+        // truncated.
+        std::string_view format(const char* fmt, ...) {
+            std::size_t available = capacity - used;
+            if (available == 0)
+                return std::string_view();
+            char* out = buffer.get() + used;
+
+            va_list args;
+            va_start(args, fmt);
+            int written = vsnprintf(out, available, fmt, args);
+            va_end(args);
+            if (written < 0)
+                return std::string_view();
+
+            std::size_t length = std::min((std::size_t)written, available - 1);
+            used += length + 1;
+            return std::string_view(out, length);
+        }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <glad/glad.h>
+
+#include <cpuTime.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+const int STATS_STATE_COUNT = 3;
+const int GPU_QUERY_RING = 4;
+
+// Wall, CPU and GPU time spent in each game state. CPU time is that of the
+// frame thread plus the renderer's workers, which the caller passes in;
+// audio and score threads are not counted. Wall and CPU time are sampled
+// once per loop iteration, so time spent blocked waiting for events counts
+// as idle time of the state that was on screen. GPU time comes from
+// GL_TIME_ELAPSED queries that are read back a few frames later to avoid
+// stalling the pipeline. Frames that find every query still in flight go
+// unmeasured, so GPU time is scaled up from the frames that were measured.
+class FrameStats {
+    struct Totals {
+        double wall = 0.0, cpu = 0.0, gpu = 0.0;
+        unsigned long long frames = 0, measuredFrames = 0;
+    };
+
+    const char* names[STATS_STATE_COUNT];
+    Totals totals[STATS_STATE_COUNT];
+    int currentState;
+    std::chrono::steady_clock::time_point lastWall;
+    double lastCpu, lastWorkerCpu;
+
+    unsigned int queries[GPU_QUERY_RING];
+    int queryState[GPU_QUERY_RING];
+    int nextQuery;
+    bool queryOpen;
+
+    void collect() {
+        for (int i = 0; i < GPU_QUERY_RING; i++) {
+            if (queryState[i] < 0)
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+            totals[queryState[i]].gpu += elapsed * 1e-9;
+            totals[queryState[i]].measuredFrames++;
+            queryState[i] = -1;
+        }
+    }
+
+    public:
+        FrameStats(const char* menuName, const char* playingName, const char* gameOverName) : currentState(0), lastWorkerCpu(0.0), nextQuery(0), queryOpen(false) {
+            names[0] = menuName;
+            names[1] = playingName;
+            names[2] = gameOverName;
+            lastWall = std::chrono::steady_clock::now();
+            lastCpu = threadCpuSeconds();
+            glGenQueries(GPU_QUERY_RING, queries);
+            for (int i = 0; i < GPU_QUERY_RING; i++)
+                queryState[i] = -1;
+        }
+
+        // Charges the time since the previous sample to the state that was
+        // active, then switches to state. workerCpu is the total CPU time so
+        // far of threads that work for the frame thread.
+        void sample(int state, double workerCpu = 0.0) {
+            auto wall = std::chrono::steady_clock::now();
+            double cpu = threadCpuSeconds();
+            totals[currentState].wall += std::chrono::duration<double>(wall - lastWall).count();
+            totals[currentState].cpu += cpu - lastCpu + workerCpu - lastWorkerCpu;
+            lastWall = wall;
+            lastCpu = cpu;
+            lastWorkerCpu = workerCpu;
+            currentState = state;
+            collect();
+        }
+
+        void beginFrame() {
+            totals[currentState].frames++;
+            if (queryState[nextQuery] >= 0)
+                return;
+            glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+            queryOpen = true;
+        }
+
+        void endFrame() {
+            if (!queryOpen)
+                return;
+            glEndQuery(GL_TIME_ELAPSED);
+            queryState[nextQuery] = currentState;
+            nextQuery = (nextQuery + 1) % GPU_QUERY_RING;
+            queryOpen = false;
+        }
+
+        void report(std::ostream& out) const {
+            out << std::fixed << std::setprecision(1);
+            for (int i = 0; i < STATS_STATE_COUNT; i++) {
+                const Totals& t = totals[i];
+                if (t.wall <= 0.0)
+                    continue;
+                double gpu = t.measuredFrames > 0 ? t.gpu * t.frames / t.measuredFrames : 0.0;
+                out << "STATS::" << names[i] << ": " << t.wall << "s, " << t.frames << " frames ("
+                    << t.frames / t.wall << " fps), CPU " << 100.0 * t.cpu / t.wall << "%, GPU "
+                    << 100.0 * gpu / t.wall << "%" << std::endl;
+            }
+        }
+};
+
+#endif
@@ -1,284 +1,270 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
-#include <textRenderer.h>
-#include <shader.h>
+#include <renderer.h>
+#include <scoreLog.h>
+#include <simulation.h>
+#include <autopilot.h>
+#include <audio.h>
+#include <frameArena.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 
 enum GameStates { MENU, PLAYING, GAME_OVER };
 
+const float ATTRACT_IDLE_SECONDS = 10.0f;
+const float ATTRACT_GAME_OVER_SECONDS = 3.0f;
+const float PLAY_FADE_IN_SECONDS = 0.4f;
+const float GAME_OVER_TRANSITION_SECONDS = 0.75f;
+
 class Game {
-	float GAME_SPEED;
-	unsigned int birdTexture, bird_koTexture, bird_45Texture, bird_45DownTexture, bird_DownTexture, bgTexture, bg_koTexture,
-					menuBgTexture, pipeTexture, birdVAO, bgVAO, pipeVAO, score, currentPipe;
-	glm::vec3 bgCurPos;
-	std::vector<glm::vec3> pipeCurPos;
+	Renderer& renderer;
+	unsigned int birdTexture, bird_45DownTexture, bird_DownTexture, bgTexture, menuBgTexture, pipeTexture;
 	float deltaTime;
-	TextRenderer menuFont, novaFont;
-
-	void play(){
-		generateBG();
-		generateBird();
-		generatePipes();
+	int menuFont, novaFont;
+	FrameArena frameArena;
+	ScoreLog scoreLog;
+	unsigned int sessionTicks, sessionFlaps;
+	Autopilot autopilot;
+	bool attractMode;
+	float idleTime;
+	bool dirty;
+	AudioMixer* audio;
+	float stateTime, shownTransition;
+
+	void setState(GameStates state) {
+		curGameState = state;
+		stateTime = 0.0f;
+		shownTransition = 0.0f;
 	}
 
-	void generateBG(bool move = true) {
-		if (bgCurPos.x <= -4.0f) {
-			bgCurPos.x = 0.0f;
-		}
-		bgShader.use();
-
-		if(move)
-			bgCurPos.x = bgCurPos.x - (GAME_SPEED * deltaTime);
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, bgCurPos);
-		bgShader.setMat4("model", model);
-
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, bgTexture);
-		glBindVertexArray(bgVAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-		glm::vec3 bgScrollPos = bgCurPos;
-		bgScrollPos.x = bgCurPos.x + 4.0f;
-		model = glm::translate(glm::mat4(1.0f), bgScrollPos);
-		bgShader.setMat4("model", model);
-
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	void playSound(int sound) {
+		if (audio)
+			audio->trigger(sound);
 	}
 
-	void generateBird() {
-		glm::mat4 model = glm::mat4(1.0f);
-		if (flyUpCount == 0) {
-			birdCurPos.y = glm::max((float)(birdCurPos.y - deltaTime), -0.77f);
-			birdShader.use();
-
-			model = glm::translate(model, birdCurPos);
-			birdShader.setMat4("model", model);
-
-			glActiveTexture(GL_TEXTURE0);
-			if (birdCurPos.y < fallPoint)
-				glBindTexture(GL_TEXTURE_2D, bird_45DownTexture);
-			else
-				glBindTexture(GL_TEXTURE_2D, birdTexture);
-			glBindVertexArray(birdVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		}
-		else {
-			birdCurPos.y = glm::min((float)(birdCurPos.y + (5*deltaTime)), 0.9f);
-			flyUpCount--;
-			if (birdCurPos.y == 0.9f)
-				flyUpCount = 0;
-			birdShader.use();
-
-			model = glm::translate(model, birdCurPos);
-			birdShader.setMat4("model", model);
-
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, birdTexture);
-			glBindVertexArray(birdVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		}
+	bool play(){
+		bool crashed = stepPlaying(world, bird, deltaTime);
+		drawBG(world);
+		drawBird(bird.pos, birdTextureFor(bird));
+		drawPipes(world);
+		return crashed;
 	}
 
-	void generatePipes(bool move = true) {
-		for (auto& curPos : pipeCurPos) {
-			if (curPos.x <= -2.5f)
-				curPos.x = 1.5f;
-
-			pipeShader.use();
-
-			if (curPos.x >= 1.5f and curPos.x <= 1.55f) {
-				curPos.y = (rand() % 50 + 50) / 100.0f;
-			}
-			if(move)
-				curPos.x = curPos.x -(GAME_SPEED * deltaTime);
-
-			glm::mat4 model = glm::mat4(1.0f);
-			model = glm::translate(model, glm::vec3(curPos.x, -curPos.y, 0.0f));
-			pipeShader.setMat4("model", model);
+	void drawBG(const WorldState& world) {
+		glm::vec2 offset(world.bgCurPos.x, world.bgCurPos.y);
+		renderer.drawSprite(bgTexture, glm::vec2(-1.0f, -1.0f) + offset, glm::vec2(3.0f, 1.0f) + offset);
+		offset.x += 4.0f;
+		renderer.drawSprite(bgTexture, glm::vec2(-1.0f, -1.0f) + offset, glm::vec2(3.0f, 1.0f) + offset);
+	}
 
-			glActiveTexture(GL_TEXTURE2);
-			glBindTexture(GL_TEXTURE_2D, pipeTexture);
-			glBindVertexArray(pipeVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	// Full-screen backgrounds keep the framing of the scrolling one.
+	void drawBackdrop(unsigned int texture) {
+		renderer.drawSprite(texture, glm::vec2(-1.0f, -1.0f), glm::vec2(3.0f, 1.0f));
+	}
 
-			model = glm::mat4(1.0f);
-			model = glm::scale(model, glm::vec3(1.0f, -1.0f, 1.0f));
-			model = glm::translate(model, glm::vec3(curPos.x, -1.5f + curPos.y, 0.0f));
-			pipeShader.setMat4("model", model);
+	unsigned int birdTextureFor(const BirdState& bird) {
+		if (bird.flyUpCount == 0 && bird.pos.y < bird.fallPoint)
+			return bird_45DownTexture;
+		return birdTexture;
+	}
 
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		}
+	void drawBird(const glm::vec3& pos, unsigned int texture) {
+		renderer.drawSprite(texture, glm::vec2(pos.x - 0.06f, pos.y - 0.10f), glm::vec2(pos.x + 0.06f, pos.y + 0.10f));
 	}
 
-	bool checkCollision() {
-		float by = birdCurPos.y;
-		for (int i = 0; i < pipeCurPos.size(); i++) {
-			float px = pipeCurPos[i].x;
-			float py = pipeCurPos[i].y;
-			if (currentPipe % pipeCurPos.size() == i and px < -0.1f and px > -1.0f) {
-				score++;
-				currentPipe++;
-			}
-			if (abs(px - 0.0f) > 0.1f)
-				continue;
-			if (by + py < 0.6f || by + py > 0.9f) {
-				return true;
-			}
+	void drawPipes(const WorldState& world) {
+		for (const auto& curPos : world.pipeCurPos) {
+			renderer.drawSprite(pipeTexture, glm::vec2(curPos.x - 0.1f, -curPos.y - 0.5f), glm::vec2(curPos.x + 0.1f, -curPos.y + 0.5f));
+			renderer.drawSprite(pipeTexture, glm::vec2(curPos.x - 0.1f, 1.0f - curPos.y), glm::vec2(curPos.x + 0.1f, 2.0f - curPos.y), true);
 		}
-		return false;
 	}
 
 	void gameOver() {
-		glm::mat4 model = glm::mat4(1.0f);
-		birdCurPos.y = glm::max((float)(birdCurPos.y - (1.5*deltaTime)), -0.77f);
-
-		if (birdCurPos.y <= -0.77f) {
-			bgShader.use();
-
-			bgShader.setMat4("model", model);
-
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, bg_koTexture);
-			glBindVertexArray(bgVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			birdShader.use();
+		bird.pos.y = glm::max((float)(bird.pos.y - (1.5*deltaTime)), BIRD_FLOOR);
 
-			birdCurPos.y = glm::max((float)(birdCurPos.y - 0.002), -0.77f);
+		if (bird.pos.y <= BIRD_FLOOR) {
+			drawBackdrop(bgTexture);
+			drawBird(glm::vec3(0.0f, BIRD_FLOOR, 1.0f), bird_DownTexture);
 
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, glm::vec3(0.0f, -0.77f, 1.0f));;
-			birdShader.setMat4("model", model);
-
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, bird_koTexture);
-			glBindVertexArray(birdVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			menuFont.RenderText("GAME OVER", 875.0f, 825.0f, 1.0f, glm::vec3(1.0f));
-			menuFont.RenderText("OK", 925.0f, 525.0f, 1.5f, glm::vec3(0.0f));
+			renderer.drawText(menuFont, "GAME OVER", 875.0f, 825.0f, 1.0f, glm::vec3(1.0f));
+			renderer.drawText(menuFont, "OK", 925.0f, 525.0f, 1.5f, glm::vec3(0.0f));
 		}
 		else {
-			generateBG(false);
-			generatePipes(false);
-
-			birdShader.use();
-			model = glm::translate(model, birdCurPos);
-			birdShader.setMat4("model", model);
-
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, bird_DownTexture);
-			glBindVertexArray(birdVAO);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			drawBG(world);
+			drawPipes(world);
+			drawBird(bird.pos, bird_DownTexture);
 		}
 	}
 
 	void showMenu() {
-		bgShader.use();
-
-		glm::mat4 model = glm::mat4(1.0f);
-		bgShader.setMat4("model", model);
-
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, menuBgTexture);
-		glBindVertexArray(bgVAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		drawBackdrop(menuBgTexture);
 		
 		if (curOption == 1) {
-			menuFont.RenderText("START", 225.0f, 100.0f, 1.5f, glm::vec3(0.0f));
-			menuFont.RenderText("HELP", 825.0f, 100.0f, 1.0f, glm::vec3(0.1f));
-			menuFont.RenderText("EXIT", 1425.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "START", 225.0f, 100.0f, 1.5f, glm::vec3(0.0f));
+			renderer.drawText(menuFont, "HELP", 825.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "EXIT", 1425.0f, 100.0f, 1.0f, glm::vec3(0.1f));
 		}
 		else if (curOption == 2) {
-			menuFont.RenderText("START", 225.0f, 100.0f, 1.0f, glm::vec3(0.1f));
-			menuFont.RenderText("HELP", 825.0f, 100.0f, 1.5f, glm::vec3(0.0f));
-			menuFont.RenderText("EXIT", 1425.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "START", 225.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "HELP", 825.0f, 100.0f, 1.5f, glm::vec3(0.0f));
+			renderer.drawText(menuFont, "EXIT", 1425.0f, 100.0f, 1.0f, glm::vec3(0.1f));
 		}
 		else if (curOption == 3) {
-			menuFont.RenderText("START", 225.0f, 100.0f, 1.0f, glm::vec3(0.1f));
-			menuFont.RenderText("HELP", 825.0f, 100.0f, 1.0f, glm::vec3(0.1f));
-			menuFont.RenderText("EXIT", 1425.0f, 100.0f, 1.5f, glm::vec3(0.0f));
+			renderer.drawText(menuFont, "START", 225.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "HELP", 825.0f, 100.0f, 1.0f, glm::vec3(0.1f));
+			renderer.drawText(menuFont, "EXIT", 1425.0f, 100.0f, 1.5f, glm::vec3(0.0f));
+		}
+
+		ScoreIndexEntry best[3];
+		int bestCount = scoreLog.topScores(best, 3);
+		if (bestCount > 0) {
+			std::string_view bestText;
+			if (bestCount == 1)
+				bestText = frameArena.format("Best: %u", best[0].score);
+			else if (bestCount == 2)
+				bestText = frameArena.format("Best: %u %u", best[0].score, best[1].score);
+			else
+				bestText = frameArena.format("Best: %u %u %u", best[0].score, best[1].score, best[2].score);
+			renderer.drawText(novaFont, bestText, 825.0f, 980.0f, 1.0f, glm::vec3(0.0f));
 		}
 	}
 
 	void showHelp() {
-		bgShader.use();
-
-		glm::mat4 model = glm::mat4(1.0f);
-		bgShader.setMat4("model", model);
-
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, menuBgTexture);
-		glBindVertexArray(bgVAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		drawBackdrop(menuBgTexture);
 
-		novaFont.RenderText("Just Tap to Fly!", 825.0f, 125.0f, 1.0f, glm::vec3(0.0f));
-		menuFont.RenderText("Take me Back", 825.0f, 75.0f, 1.0f, glm::vec3(0.0f));
+		renderer.drawText(novaFont, "Just Tap to Fly!", 825.0f, 125.0f, 1.0f, glm::vec3(0.0f));
+		renderer.drawText(menuFont, "Take me Back", 825.0f, 75.0f, 1.0f, glm::vec3(0.0f));
 	}
 
 	public:
-		Shader bgShader, birdShader, pipeShader;
-		unsigned int flyUpCount, curOption;
-		float fallPoint;
+		unsigned int curOption;
 		GameStates curGameState;
-		glm::vec3 birdCurPos;
+		WorldState world;
+		BirdState bird;
 		bool enterPressed;
 
-		Game(unsigned int birdShaderID, unsigned int bgShaderID, unsigned int pipeShaderID,
-			unsigned int birdTexture, unsigned int bird_koTexture, unsigned int bird_45DownTexture, unsigned int bird_DownTexture,
-			unsigned int bgTexture, unsigned int bg_koTexture, unsigned int menuBgTexture, unsigned int pipeTexture,
-			unsigned int birdVAO, unsigned int bgVAO, unsigned int pipeVAO) 
-			: GAME_SPEED(0.4){
+		Game(Renderer& renderer)
+			: renderer(renderer), frameArena(16 * 1024), scoreLog("scores.log", "scores.idx"), audio(nullptr), stateTime(0.0f), shownTransition(0.0f){
 			
-			this->bgShader.SetID(bgShaderID);
-			this->birdShader.SetID(birdShaderID);
-			this->pipeShader.SetID(pipeShaderID);
-			this->birdTexture = birdTexture;
-			this->bird_koTexture = bird_koTexture;
-			this->bird_45DownTexture = bird_45DownTexture;
-			this->bird_DownTexture = bird_DownTexture;
-			this->bgTexture = bgTexture;
-			this->bg_koTexture = bg_koTexture;
-			this->menuBgTexture = menuBgTexture;
-			this->pipeTexture = pipeTexture;
-			this->birdVAO = birdVAO;
-			this->bgVAO = bgVAO;
-			this->pipeVAO = pipeVAO;
-			this->menuFont = *(new TextRenderer("fonts/peligroso.otf", "shaders/text.vs", "shaders/text.fs", 0, 48));
-			this->novaFont = *(new TextRenderer("fonts/nova.otf", "shaders/text.vs", "shaders/text.fs", 0, 48));
+			this->birdTexture = renderer.loadTexture("images/flappy.png");
+			this->bird_45DownTexture = renderer.loadTexture("images/flappy_45-.png");
+			this->bird_DownTexture = renderer.loadTexture("images/flappy_down.png");
+			this->bgTexture = renderer.loadTexture("images/city-bg-long.png");
+			this->menuBgTexture = renderer.loadTexture("images/menu-bg.jpg");
+			this->pipeTexture = renderer.loadTexture("images/pipe.png");
+			this->menuFont = renderer.loadFont("fonts/peligroso.otf", 48);
+			this->novaFont = renderer.loadFont("fonts/nova.otf", 48);
 		}
 
 		void init() {
-			birdCurPos = glm::vec3(0.0f);
-			bgCurPos = glm::vec3(0.0f);
-			pipeCurPos = { glm::vec3(1.5f, 0.0f, 0.0f), glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(2.5f, 0.0f, 0.0f), glm::vec3(3.0f),
-											glm::vec3(3.5f, 0.0f, 0.0f), glm::vec3(4.0f, 0.0f, 0.0f), glm::vec3(4.5f, 0.0f, 0.0f), glm::vec3(5.0f, 0.0f, 0.0f) };
-			flyUpCount = 0;
-			score = 0;
-			currentPipe = 0;
-			fallPoint = 0.0;
-			curGameState = MENU;
+			resetWorld(world, (uint32_t)rand());
+			resetBird(bird);
+			setState(MENU);
 			curOption = 1;
 			enterPressed = false;
+			sessionTicks = 0;
+			sessionFlaps = 0;
+			attractMode = false;
+			idleTime = 0.0f;
+			dirty = true;
+		}
+
+		void startAttract() {
+			resetWorld(world, (uint32_t)rand());
+			resetBird(bird);
+			autopilot.reset();
+			attractMode = true;
+			setState(PLAYING);
+		}
+
+		void markDirty() {
+			dirty = true;
+		}
+
+		bool isDirty() const {
+			return dirty;
+		}
+
+		// True when another frame would look exactly like the last one until
+		// input arrives or wakeTimeout() elapses.
+		bool isStatic() const {
+			if (curGameState == MENU)
+				return !(enterPressed && curOption == 1);
+			if (curGameState == GAME_OVER)
+				return bird.pos.y <= BIRD_FLOOR && shownTransition >= 1.0f;
+			return false;
+		}
+
+		// Seconds until a static screen changes by itself, or a negative
+		// value if it only changes on input.
+		double wakeTimeout() const {
+			if (curGameState == MENU && !enterPressed)
+				return std::max(ATTRACT_IDLE_SECONDS - idleTime, 0.0f);
+			if (curGameState == GAME_OVER && attractMode)
+				return std::max(ATTRACT_GAME_OVER_SECONDS - idleTime, 0.0f);
+			return -1.0;
+		}
+
+		// Any key press ends the attract-mode demo and restarts the idle
+		// countdown. Returns true if the press was used to leave the demo.
+		bool wake() {
+			idleTime = 0.0f;
+			if (!attractMode)
+				return false;
+			init();
+			return true;
+		}
+
+		void setAudio(AudioMixer* audio) {
+			this->audio = audio;
+		}
+
+		void flap() {
+			::flap(bird);
+			if (curGameState == PLAYING) {
+				sessionFlaps++;
+				playSound(SOUND_FLAP);
+			}
+		}
+
+		// Picks the post effects for the current state. Call before the
+		// renderer clears the frame.
+		void beginFrame() {
+			float fade = 0.0f, drained = 0.0f;
+			if (curGameState == PLAYING)
+				fade = 1.0f - stateTime / PLAY_FADE_IN_SECONDS;
+			else if (curGameState == GAME_OVER)
+				drained = std::min(stateTime / GAME_OVER_TRANSITION_SECONDS, 1.0f);
+			renderer.setEffect(POST_GRAYSCALE, drained);
+			renderer.setEffect(POST_VIGNETTE, drained);
+			renderer.setEffect(POST_FADE, fade);
+			shownTransition = drained;
+		}
+
+		void resize(int width, int height) {
+			renderer.resize(width, height);
 		}
 
 		void run(float deltaTime) {
+			stateTime += deltaTime;
 			//TODO - Rendering is not smooth when actual deltaTime is used
-			this->deltaTime = 0.002;
+			this->deltaTime = SIM_DELTA;
+			dirty = false;
+			frameArena.reset();
 			if (curGameState == MENU) {
 				if (enterPressed == false) {
 					showMenu();
+					idleTime += deltaTime;
+					if (idleTime >= ATTRACT_IDLE_SECONDS)
+						startAttract();
 				}
 				else {
 					if (curOption == 1) {
-						curGameState = PLAYING;
+						setState(PLAYING);
 					}
 					else if (curOption == 2) {
 						showHelp();
@@ -286,19 +272,72 @@ class Game {
 				}
 			}
 			else if (curGameState == PLAYING) {
-				play();
-				if (birdCurPos.y <= -0.77f || checkCollision()) {
-					curGameState = GAME_OVER;
+				if (attractMode) {
+					if (autopilot.think(world, bird))
+						::flap(bird);
+					if (play()) {
+						setState(GAME_OVER);
+						idleTime = 0.0f;
+					}
+					const AutopilotStats& stats = autopilot.getStats();
+					renderer.drawText(novaFont, frameArena.format("DEMO  nodes %u  %dus", stats.nodesSearched, (int)stats.decisionMicros),
+						25.0f, 940.0f, 0.75f, glm::vec3(1.0f));
+					return;
+				}
+				sessionTicks++;
+				unsigned int lastScore = bird.score;
+				bool crashed = play();
+				if (bird.score != lastScore)
+					playSound(SOUND_SCORE);
+				if (crashed) {
+					setState(GAME_OVER);
+					playSound(SOUND_CRASH);
+					scoreLog.record({ bird.score, sessionTicks, sessionFlaps });
 				}
 			}
 			else if (curGameState == GAME_OVER) {
 				gameOver();
+				if (attractMode) {
+					idleTime += deltaTime;
+					if (idleTime >= ATTRACT_GAME_OVER_SECONDS)
+						init();
+				}
 			}
 		}
 
+		// Draws a race as seen by one peer; the simulation itself is advanced
+		// by a RollbackSession.
+		void runRace(const RaceState& race, int localPlayer) {
+			frameArena.reset();
+			drawBG(race.world);
+			for (int i = 0; i < RACE_PLAYERS; i++) {
+				int player = (localPlayer + 1 + i) % RACE_PLAYERS;
+				const BirdState& racer = race.birds[player];
+				drawBird(racer.pos, race.crashed[player] ? bird_DownTexture : birdTextureFor(racer));
+			}
+			drawPipes(race.world);
+
+			if (raceFinished(race)) {
+				const char* result = "DRAW";
+				if (race.birds[localPlayer].score != race.birds[1 - localPlayer].score)
+					result = race.birds[localPlayer].score > race.birds[1 - localPlayer].score ? "YOU WIN" : "YOU LOSE";
+				renderer.drawText(menuFont, "GAME OVER", 875.0f, 825.0f, 1.0f, glm::vec3(1.0f));
+				renderer.drawText(menuFont, result, 875.0f, 525.0f, 1.5f, glm::vec3(0.0f));
+			}
+		}
+
+		const AutopilotStats& getAutopilotStats() const {
+			return autopilot.getStats();
+		}
+
+		// Scratch space for text formatted during the current frame.
+		FrameArena& getFrameArena() {
+			return frameArena;
+		}
+
 		int getScore() {
-			return this->score;
+			return this->bird.score;
 		}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,183 @@
+#ifndef GL_RENDERER_H
+#define GL_RENDERER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <renderer.h>
+#include <shader.h>
+#include <vao.h>
+#include <textRenderer.h>
+#include <postProcess.h>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Draws through OpenGL. Every sprite is the same textured quad moved into
+// place by its model matrix, so one program and one VAO cover them all.
+class GlRenderer : public Renderer {
+    Shader spriteShader;
+    int modelLocation;
+    unsigned int quadVAO;
+    PostProcess post;
+    std::vector<std::unique_ptr<TextRenderer>> fonts;
+
+    public:
+        GlRenderer(int width, int height) : spriteShader("shaders/bg.vs", "shaders/bg.fs"), post(width, height) {
+            spriteShader.use();
+            glUniform1i(spriteShader.getUniformLocation("bgTexture"), 1);
+            modelLocation = spriteShader.getUniformLocation("model");
+
+            float quadVertices[] = {
+                // positions          // texture coords
+                 1.0f,  1.0f, 0.0f,   1.0f, 1.0f,   // top right
+                 1.0f, -1.0f, 0.0f,   1.0f, 0.0f,   // bottom right
+                -1.0f, -1.0f, 0.0f,   0.0f, 0.0f,   // bottom left
+                -1.0f,  1.0f, 0.0f,   0.0f, 1.0f    // top left
+            };
+            unsigned int quadIndices[] = {
+                0, 1, 3,
+                1, 2, 3
+            };
+            Vao quad(quadVertices, quadIndices, sizeof(quadVertices), sizeof(quadIndices));
+            quadVAO = quad.VAO;
+        }
+
+        GlRenderer(const GlRenderer&) = delete;
+        GlRenderer& operator=(const GlRenderer&) = delete;
+
+        ~GlRenderer() {
+            glDeleteVertexArrays(1, &quadVAO);
+        }
+
+        unsigned int loadTexture(const char* path) override {
+            unsigned int textureID;
+            glGenTextures(1, &textureID);
+
+            stbi_set_flip_vertically_on_load(true);
+            int width, height, nrComponents;
+            unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+            if (data) {
+                GLenum format = GL_RGBA;
+                if (nrComponents == 1)
+                    format = GL_RED;
+                else if (nrComponents == 3)
+                    format = GL_RGB;
+
+                glBindTexture(GL_TEXTURE_2D, textureID);
+                glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+                glGenerateMipmap(GL_TEXTURE_2D);
+
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+                stbi_image_free(data);
+            }
+            else {
+                std::cout << "Texture failed to load at path: " << path << std::endl;
+                stbi_image_free(data);
+            }
+
+            return textureID;
+        }
+
+        int loadFont(const char* path, int pixelSize) override {
+            fonts.emplace_back(new TextRenderer(path, "shaders/text.vs", "shaders/text.fs", 0, pixelSize));
+            return (int)fonts.size() - 1;
+        }
+
+        void setEffect(int effect, float amount) override {
+            post.setAmount(effect, amount);
+        }
+
+        void resize(int width, int height) override {
+            post.resize(width, height);
+        }
+
+        void clear(const glm::vec3& color) override {
+            post.begin();
+            glClearColor(color.x, color.y, color.z, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
+        void drawSprite(unsigned int texture, const glm::vec2& min, const glm::vec2& max, bool flipV = false) override {
+            spriteShader.use();
+
+            glm::vec2 center = (min + max) * 0.5f;
+            glm::vec2 half = (max - min) * 0.5f;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(center, 0.0f));
+            model = glm::scale(model, glm::vec3(half.x, flipV ? -half.y : half.y, 1.0f));
+            spriteShader.setMat4(modelLocation, model);
+
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glBindVertexArray(quadVAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+
+        void drawText(int font, std::string_view text, float x, float y, float scale, const glm::vec3& color) override {
+            fonts[font]->RenderText(text, x, y, scale, color);
+        }
+
+        void present() override {
+            post.end();
+        }
+};
+
+// Puts frames rendered in memory on screen by stretching them over the
+// default framebuffer.
+class GlFrameDisplay : public FrameSink {
+    Shader shader;
+    unsigned int texture, emptyVAO;
+    int width, height;
+
+    public:
+        GlFrameDisplay() : shader("shaders/post.vs", "shaders/blit.fs"), width(0), height(0) {
+            shader.use();
+            glUniform1i(shader.getUniformLocation("frame"), 3);
+            glGenVertexArrays(1, &emptyVAO);
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        GlFrameDisplay(const GlFrameDisplay&) = delete;
+        GlFrameDisplay& operator=(const GlFrameDisplay&) = delete;
+
+        ~GlFrameDisplay() {
+            glDeleteTextures(1, &texture);
+            glDeleteVertexArrays(1, &emptyVAO);
+            glDeleteProgram(shader.ID);
+        }
+
+        void show(const uint32_t* pixels, int width, int height) override {
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            if (width != this->width || height != this->height) {
+                this->width = width;
+                this->height = height;
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            }
+            else {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDisable(GL_BLEND);
+            shader.use();
+            glBindVertexArray(emptyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEnable(GL_BLEND);
+        }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <glad/glad.h>
+#include <shader.h>
+#include <renderer.h>
+
+#include <algorithm>
+#include <iostream>
+
+// Full-screen effects applied after the scene is drawn. Each effect is its
+// own pass with an amount in [0, 1]; passes with amount 0 are skipped, and
+// when none are active the scene is drawn straight to the screen with no
+// offscreen copy at all. Active passes ping-pong between two color targets
+// and the last one writes to the default framebuffer. Every pass draws the
+// same full-screen triangle, generated in the vertex shader.
+class PostProcess {
+    unsigned int framebuffers[2], colorTextures[2];
+    unsigned int emptyVAO;
+    int width, height;
+    Shader passes[POST_EFFECT_COUNT];
+    int amountLocations[POST_EFFECT_COUNT];
+    float amounts[POST_EFFECT_COUNT];
+    bool capturing;
+
+    void allocateTargets() {
+        for (int i = 0; i < 2; i++) {
+            glBindTexture(GL_TEXTURE_2D, colorTextures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+    }
+
+    public:
+        PostProcess(int width, int height) : width(std::max(width, 1)), height(std::max(height, 1)), capturing(false) {
+            const char* fragmentPaths[POST_EFFECT_COUNT] = { "shaders/grayscale.fs", "shaders/vignette.fs", "shaders/fade.fs" };
+            for (int i = 0; i < POST_EFFECT_COUNT; i++) {
+                passes[i] = Shader("shaders/post.vs", fragmentPaths[i]);
+                passes[i].use();
+                glUniform1i(passes[i].getUniformLocation("scene"), 3);
+                amountLocations[i] = passes[i].getUniformLocation("amount");
+                amounts[i] = 0.0f;
+            }
+
+            glGenVertexArrays(1, &emptyVAO);
+            glGenFramebuffers(2, framebuffers);
+            glGenTextures(2, colorTextures);
+            allocateTargets();
+            for (int i = 0; i < 2; i++) {
+                glBindTexture(GL_TEXTURE_2D, colorTextures[i]);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTextures[i], 0);
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                    std::cout << "ERROR::POST_PROCESS: Framebuffer is not complete" << std::endl;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        PostProcess(const PostProcess&) = delete;
+        PostProcess& operator=(const PostProcess&) = delete;
+
+        ~PostProcess() {
+            glDeleteFramebuffers(2, framebuffers);
+            glDeleteTextures(2, colorTextures);
+            glDeleteVertexArrays(1, &emptyVAO);
+            for (int i = 0; i < POST_EFFECT_COUNT; i++)
+                glDeleteProgram(passes[i].ID);
+        }
+
+        void resize(int width, int height) {
+            this->width = std::max(width, 1);
+            this->height = std::max(height, 1);
+            allocateTargets();
+        }
+
+        void setAmount(int effect, float amount) {
+            amounts[effect] = std::min(std::max(amount, 0.0f), 1.0f);
+        }
+
+        bool isActive() const {
+            for (int i = 0; i < POST_EFFECT_COUNT; i++)
+                if (amounts[i] > 0.0f)
+                    return true;
+            return false;
+        }
+
+        // Call before the scene is cleared and drawn.
+        void begin() {
+            capturing = isActive();
+            glBindFramebuffer(GL_FRAMEBUFFER, capturing ? framebuffers[0] : 0);
+        }
+
+        // Runs the active passes and leaves the result on screen.
+        void end() {
+            if (!capturing)
+                return;
+            capturing = false;
+
+            int last = 0;
+            for (int i = 0; i < POST_EFFECT_COUNT; i++)
+                if (amounts[i] > 0.0f)
+                    last = i;
+
+            glDisable(GL_BLEND);
+            glBindVertexArray(emptyVAO);
+            glActiveTexture(GL_TEXTURE3);
+            int source = 0;
+            for (int i = 0; i <= last; i++) {
+                if (amounts[i] <= 0.0f)
+                    continue;
+                glBindFramebuffer(GL_FRAMEBUFFER, i == last ? 0 : framebuffers[1 - source]);
+                glBindTexture(GL_TEXTURE_2D, colorTextures[source]);
+                passes[i].use();
+                glUniform1f(amountLocations[i], amounts[i]);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                source = 1 - source;
+            }
+            glEnable(GL_BLEND);
+        }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string_view>
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+enum PostEffects { POST_GRAYSCALE, POST_VIGNETTE, POST_FADE, POST_EFFECT_COUNT };
+
+// Decodes one UTF-8 sequence and advances p past it. Malformed input yields
+// U+FFFD and skips a single byte.
+inline char32_t decodeUtf8(const char*& p, const char* end) {
+    unsigned char c = (unsigned char)*p++;
+    if (c < 0x80)
+        return c;
+
+    int extra;
+    char32_t cp;
+    if ((c & 0xE0) == 0xC0) {
+        extra = 1;
+        cp = c & 0x1F;
+    }
+    else if ((c & 0xF0) == 0xE0) {
+        extra = 2;
+        cp = c & 0x0F;
+    }
+    else if ((c & 0xF8) == 0xF0) {
+        extra = 3;
+        cp = c & 0x07;
+    }
+    else {
+        return 0xFFFD;
+    }
+
+    if (end - p < extra)
+        return 0xFFFD;
+    for (int i = 0; i < extra; i++) {
+        if ((p[i] & 0xC0) != 0x80)
+            return 0xFFFD;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    p += extra;
+    return cp;
+}
+
+// Everything the game draws goes through this interface. A frame is
+// clear(), any number of draws in back-to-front order, then present().
+class Renderer {
+    public:
+        virtual ~Renderer() {}
+
+        virtual unsigned int loadTexture(const char* path) = 0;
+        virtual int loadFont(const char* path, int pixelSize) = 0;
+
+        // Post effects apply to the whole of the next frame.
+        virtual void setEffect(int effect, float amount) = 0;
+        virtual void resize(int width, int height) = 0;
+
+        virtual void clear(const glm::vec3& color) = 0;
+        // Stretches a texture over [min, max] in normalized device
+        // coordinates. flipV mirrors it vertically.
+        virtual void drawSprite(unsigned int texture, const glm::vec2& min, const glm::vec2& max, bool flipV = false) = 0;
+        // Text is UTF-8, placed in SCR_WIDTH x SCR_HEIGHT pixels from the
+        // bottom left with y on the baseline.
+        virtual void drawText(int font, std::string_view text, float x, float y, float scale, const glm::vec3& color) = 0;
+        virtual void present() = 0;
+
+        // CPU seconds used so far by threads the renderer draws on besides
+        // the caller's.
+        virtual double workerCpuSeconds() const {
+            return 0.0;
+        }
+};
+
+// Receives frames rendered into memory, e.g. to show them in a window.
+// Pixels are RGBA bytes, rows stored top to bottom.
+class FrameSink {
+    public:
+        virtual ~FrameSink() {}
+        virtual void show(const uint32_t* pixels, int width, int height) = 0;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <simulation.h>
+#include <transport.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+const uint32_t ROLLBACK_WINDOW = 16;
+const uint32_t INPUT_RING = 2 * ROLLBACK_WINDOW;
+const uint32_t PACKET_HEADER = 10;
+const uint32_t NO_FRAME = 0xFFFFFFFFu;
+
+struct RollbackStats {
+    uint32_t rollbacks = 0;
+    uint32_t lastDepth = 0;
+    uint32_t maxDepth = 0;
+    uint32_t stalls = 0;
+    double lastResimMicros = 0.0;
+    double maxResimMicros = 0.0;
+};
+
+// One peer of a two-player race. Local input is applied immediately and the
+// remote bird is predicted not to flap; when the real remote input for an
+// already simulated frame disagrees, the saved state of that frame is
+// restored and every frame since is re-simulated before the next tick.
+//
+// Each packet carries the sender's confirmed frame as an acknowledgement and
+// repeats every local input from the peer's last acknowledgement onwards, so
+// any run of lost packets is covered by the next one that gets through.
+class RollbackSession {
+    Transport& transport;
+    int localPlayer, remotePlayer;
+    RaceState current;
+    RaceState history[ROLLBACK_WINDOW];
+    uint8_t inputs[RACE_PLAYERS][INPUT_RING];
+    uint32_t remoteKnown[INPUT_RING];
+    uint32_t confirmedFrame;
+    uint32_t remoteAck;
+    RollbackStats stats;
+
+    void simulateFrame(uint32_t frame) {
+        uint32_t slot = frame % INPUT_RING;
+        if (remoteKnown[slot] != frame)
+            inputs[remotePlayer][slot] = 0;
+
+        uint8_t frameInputs[RACE_PLAYERS];
+        frameInputs[localPlayer] = inputs[localPlayer][slot];
+        frameInputs[remotePlayer] = inputs[remotePlayer][slot];
+
+        history[frame % ROLLBACK_WINDOW] = current;
+        stepRace(current, frameInputs);
+    }
+
+    // The stall check keeps lastFrame within INPUT_RING frames of the
+    // peer's acknowledgement, so every unacknowledged input is still held.
+    void sendInputs(uint32_t lastFrame) {
+        uint32_t count = lastFrame + 1 > remoteAck ? std::min(lastFrame + 1 - remoteAck, INPUT_RING) : 0;
+        Packet packet;
+        std::memcpy(packet.data, &lastFrame, sizeof(lastFrame));
+        std::memcpy(packet.data + 4, &confirmedFrame, sizeof(confirmedFrame));
+        packet.data[8] = (uint8_t)localPlayer;
+        packet.data[9] = (uint8_t)count;
+        for (uint32_t i = 0; i < count; i++)
+            packet.data[PACKET_HEADER + i] = inputs[localPlayer][(lastFrame - count + 1 + i) % INPUT_RING];
+        packet.size = PACKET_HEADER + count;
+        transport.send(packet);
+    }
+
+    // Returns the earliest simulated frame whose remote input was mispredicted,
+    // or the current frame if nothing needs replaying.
+    uint32_t poll() {
+        uint32_t rollbackTo = current.frame;
+        Packet packet;
+        while (transport.receive(packet)) {
+            if (packet.size < PACKET_HEADER || packet.data[8] != remotePlayer || packet.size != PACKET_HEADER + packet.data[9])
+                continue;
+            uint32_t lastFrame, ack;
+            std::memcpy(&lastFrame, packet.data, sizeof(lastFrame));
+            std::memcpy(&ack, packet.data + 4, sizeof(ack));
+            remoteAck = std::max(remoteAck, ack);
+            uint32_t count = packet.data[9];
+
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t frame = lastFrame - count + 1 + i;
+                if (frame < confirmedFrame || frame >= confirmedFrame + INPUT_RING)
+                    continue;
+                uint32_t slot = frame % INPUT_RING;
+                if (remoteKnown[slot] == frame)
+                    continue;
+                uint8_t input = packet.data[PACKET_HEADER + i];
+                if (frame < current.frame && inputs[remotePlayer][slot] != input)
+                    rollbackTo = std::min(rollbackTo, frame);
+                inputs[remotePlayer][slot] = input;
+                remoteKnown[slot] = frame;
+            }
+        }
+        while (remoteKnown[confirmedFrame % INPUT_RING] == confirmedFrame)
+            confirmedFrame++;
+        return rollbackTo;
+    }
+
+    public:
+        RollbackSession(Transport& transport, int localPlayer, uint32_t seed)
+            : transport(transport), localPlayer(localPlayer), remotePlayer(1 - localPlayer), confirmedFrame(0), remoteAck(0) {
+            resetRace(current, seed);
+            std::memset(inputs, 0, sizeof(inputs));
+            std::fill(remoteKnown, remoteKnown + INPUT_RING, NO_FRAME);
+        }
+
+        // Runs one tick. Returns false without consuming the input when the
+        // peer has fallen more than the rollback window behind.
+        bool advance(uint8_t localInput) {
+            uint32_t frame = current.frame;
+            uint32_t rollbackTo = poll();
+
+            if (rollbackTo < frame) {
+                auto start = std::chrono::steady_clock::now();
+                current = history[rollbackTo % ROLLBACK_WINDOW];
+                for (uint32_t f = rollbackTo; f < frame; f++)
+                    simulateFrame(f);
+                double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+                stats.rollbacks++;
+                stats.lastDepth = frame - rollbackTo;
+                stats.maxDepth = std::max(stats.maxDepth, stats.lastDepth);
+                stats.lastResimMicros = micros;
+                stats.maxResimMicros = std::max(stats.maxResimMicros, micros);
+            }
+
+            if (frame - confirmedFrame >= ROLLBACK_WINDOW - 1) {
+                if (frame > 0)
+                    sendInputs(frame - 1);
+                stats.stalls++;
+                return false;
+            }
+
+            inputs[localPlayer][frame % INPUT_RING] = localInput;
+            sendInputs(frame);
+            simulateFrame(frame);
+            return true;
+        }
+
+        const RaceState& state() const {
+            return current;
+        }
+
+        const RollbackStats& getStats() const {
+            return stats;
+        }
+
+        uint32_t getConfirmedFrame() const {
+            return confirmedFrame;
+        }
+};
+
+#endif
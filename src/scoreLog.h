@@ -0,0 +1,371 @@
+#ifndef SCORE_LOG_H
+#define SCORE_LOG_H
+
+#include <spscQueue.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const uint32_t SCORE_RECORD_MAGIC = 0x52435346;
+const uint32_t SCORE_INDEX_MAGIC = 0x58495346;
+const int SCORE_TOP_N = 10;
+
+struct SessionStats {
+    uint32_t score;
+    uint32_t ticks;
+    uint32_t flaps;
+};
+
+// One fixed-size entry of the append-only log. The checksum covers every
+// preceding field, so a record cut short by a crash is detected on startup.
+struct ScoreRecord {
+    uint32_t magic;
+    uint32_t sequence;
+    int64_t  timestamp;
+    uint32_t score;
+    uint32_t ticks;
+    uint32_t flaps;
+    uint32_t checksum;
+};
+static_assert(sizeof(ScoreRecord) == 32, "ScoreRecord must stay packed");
+
+struct ScoreIndexEntry {
+    uint32_t score;
+    uint32_t sequence;
+};
+
+// Layout of the memory-mapped index file. version is a seqlock counter: it is
+// odd while the writer thread is updating entries.
+struct ScoreIndex {
+    uint32_t magic;
+    std::atomic<uint32_t> version;
+    uint32_t recordCount;
+    uint32_t entryCount;
+    ScoreIndexEntry entries[SCORE_TOP_N];
+    uint32_t checksum;
+};
+
+inline uint32_t crc32(const void* data, std::size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++)
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+class MappedFile {
+    void* view = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+
+    public:
+        MappedFile() {}
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() {
+            close();
+        }
+
+        bool open(const std::string& path, std::size_t size) {
+            this->size = size;
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, (DWORD)size, NULL);
+            if (mapping == NULL)
+                return false;
+            view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0 || ftruncate(fd, size) != 0)
+                return false;
+            view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (view == MAP_FAILED)
+                view = nullptr;
+#endif
+            return view != nullptr;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (view)
+                UnmapViewOfFile(view);
+            if (mapping != NULL)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            mapping = NULL;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (view)
+                munmap(view, size);
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+#endif
+            view = nullptr;
+        }
+
+        void* data() const {
+            return view;
+        }
+};
+
+// Persistent high scores and per-session stats. record() is called from the
+// frame thread and only pushes onto a lock-free queue; all file I/O happens on
+// the writer thread. Top scores are served from a small memory-mapped index
+// so the menu never has to scan the log.
+class ScoreLog {
+    std::string logPath;
+    FILE* log = nullptr;
+    MappedFile indexFile;
+    ScoreIndex* index = nullptr;
+    ScoreIndex fallbackIndex{};
+    uint32_t nextSequence = 0;
+
+    SpscQueue<SessionStats, 64> pending;
+    std::atomic<bool> running{ false };
+    std::atomic<uint32_t> dropped{ 0 };
+    std::mutex wakeMutex;
+    std::condition_variable wakeWriter;
+    std::thread writer;
+
+    static uint32_t recordChecksum(const ScoreRecord& rec) {
+        return crc32(&rec, offsetof(ScoreRecord, checksum));
+    }
+
+    static uint32_t indexChecksum(const ScoreIndex& idx) {
+        uint32_t crc = crc32(&idx.recordCount, sizeof(idx.recordCount));
+        crc = crc32(&idx.entryCount, sizeof(idx.entryCount), crc);
+        return crc32(idx.entries, sizeof(idx.entries), crc);
+    }
+
+    static void insertTop(ScoreIndex& idx, ScoreIndexEntry entry) {
+        uint32_t pos = idx.entryCount;
+        while (pos > 0 && idx.entries[pos - 1].score < entry.score)
+            pos--;
+        if (pos >= (uint32_t)SCORE_TOP_N)
+            return;
+        uint32_t last = std::min(idx.entryCount, (uint32_t)SCORE_TOP_N - 1);
+        for (uint32_t i = last; i > pos; i--)
+            idx.entries[i] = idx.entries[i - 1];
+        idx.entries[pos] = entry;
+        idx.entryCount = std::min(idx.entryCount + 1, (uint32_t)SCORE_TOP_N);
+    }
+
+    bool isValid(const ScoreRecord& rec, uint32_t sequence) const {
+        return rec.magic == SCORE_RECORD_MAGIC && rec.sequence == sequence && rec.checksum == recordChecksum(rec);
+    }
+
+    // Walks back from the end of the log until the last record checks out and
+    // cuts off whatever follows it, so only a torn tail is ever discarded.
+    uint32_t recover() {
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(logPath, ec);
+        if (ec)
+            return 0;
+
+        std::uintmax_t valid = size - size % sizeof(ScoreRecord);
+        std::ifstream in(logPath, std::ios::binary);
+        ScoreRecord rec;
+        while (valid > 0) {
+            in.clear();
+            in.seekg(valid - sizeof(ScoreRecord));
+            in.read(reinterpret_cast<char*>(&rec), sizeof(rec));
+            if (in && isValid(rec, (uint32_t)(valid / sizeof(ScoreRecord) - 1)))
+                break;
+            valid -= sizeof(ScoreRecord);
+        }
+        in.close();
+
+        if (valid != size) {
+            std::filesystem::resize_file(logPath, valid, ec);
+            std::cout << "SCORELOG::RECOVERED: dropped " << (size - valid) << " bytes of torn tail" << std::endl;
+        }
+        return (uint32_t)(valid / sizeof(ScoreRecord));
+    }
+
+    void rebuildIndex(uint32_t recordCount) {
+        index->version.fetch_add(1, std::memory_order_acq_rel);
+        index->magic = SCORE_INDEX_MAGIC;
+        index->recordCount = 0;
+        index->entryCount = 0;
+
+        std::ifstream in(logPath, std::ios::binary);
+        ScoreRecord rec;
+        while (index->recordCount < recordCount && in.read(reinterpret_cast<char*>(&rec), sizeof(rec))) {
+            if (!isValid(rec, index->recordCount))
+                break;
+            insertTop(*index, { rec.score, rec.sequence });
+            index->recordCount++;
+        }
+        index->checksum = indexChecksum(*index);
+        index->version.fetch_add(1, std::memory_order_release);
+    }
+
+    void append(const SessionStats& stats, ScoreRecord& rec) {
+        rec.magic = SCORE_RECORD_MAGIC;
+        rec.sequence = nextSequence++;
+        rec.timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        rec.score = stats.score;
+        rec.ticks = stats.ticks;
+        rec.flaps = stats.flaps;
+        rec.checksum = recordChecksum(rec);
+        fwrite(&rec, sizeof(rec), 1, log);
+    }
+
+    void sync() {
+        fflush(log);
+#ifdef _WIN32
+        _commit(_fileno(log));
+#else
+        fsync(fileno(log));
+#endif
+    }
+
+    void writeLoop() {
+        SessionStats batch[64];
+        ScoreRecord recs[64];
+        while (true) {
+            bool stop = !running.load(std::memory_order_acquire);
+
+            int count = 0;
+            while (count < 64 && pending.pop(batch[count]))
+                count++;
+
+            if (count > 0 && log) {
+                for (int i = 0; i < count; i++)
+                    append(batch[i], recs[i]);
+                sync();
+
+                index->version.fetch_add(1, std::memory_order_acq_rel);
+                for (int i = 0; i < count; i++)
+                    insertTop(*index, { recs[i].score, recs[i].sequence });
+                index->recordCount = nextSequence;
+                index->checksum = indexChecksum(*index);
+                index->version.fetch_add(1, std::memory_order_release);
+            }
+
+            if (stop && pending.empty())
+                break;
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeWriter.wait(lock, [&] { return !running.load(std::memory_order_acquire) || !pending.empty(); });
+        }
+    }
+
+    public:
+        ScoreLog(const std::string& logPath, const std::string& indexPath) : logPath(logPath) {
+            nextSequence = recover();
+
+            if (indexFile.open(indexPath, sizeof(ScoreIndex))) {
+                index = static_cast<ScoreIndex*>(indexFile.data());
+            }
+            else {
+                std::cout << "ERROR::SCORELOG: Failed to map index " << indexPath << std::endl;
+                index = &fallbackIndex;
+            }
+            if (index->magic != SCORE_INDEX_MAGIC || index->recordCount != nextSequence || index->checksum != indexChecksum(*index))
+                rebuildIndex(nextSequence);
+            if (index->version.load(std::memory_order_relaxed) & 1)
+                index->version.fetch_add(1, std::memory_order_relaxed);
+
+            log = fopen(logPath.c_str(), "ab");
+            if (!log)
+                std::cout << "ERROR::SCORELOG: Failed to open " << logPath << std::endl;
+
+            running.store(true, std::memory_order_release);
+            writer = std::thread(&ScoreLog::writeLoop, this);
+        }
+
+        ScoreLog(const ScoreLog&) = delete;
+        ScoreLog& operator=(const ScoreLog&) = delete;
+
+        ~ScoreLog() {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                running.store(false, std::memory_order_release);
+            }
+            wakeWriter.notify_one();
+            if (writer.joinable())
+                writer.join();
+            if (log)
+                fclose(log);
+        }
+
+        // Never waits on I/O: if the writer has fallen behind the session is
+        // dropped. The lock only guards the writer's wake-up check, so that a
+        // push cannot slip in between its check and its wait.
+        bool record(const SessionStats& stats) {
+            if (pending.push(stats)) {
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                }
+                wakeWriter.notify_one();
+                return true;
+            }
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        int topScores(ScoreIndexEntry* out, int n) const {
+            uint32_t before, count;
+            do {
+                before = index->version.load(std::memory_order_acquire);
+                count = std::min((uint32_t)n, index->entryCount);
+                for (uint32_t i = 0; i < count; i++)
+                    out[i] = index->entries[i];
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while ((before & 1) || before != index->version.load(std::memory_order_relaxed));
+            return (int)count;
+        }
+
+        uint32_t droppedSessions() const {
+            return dropped.load(std::memory_order_relaxed);
+        }
+};
+
+#endif
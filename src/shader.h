@@ -97,6 +97,10 @@ public:
         glUseProgram(ID);
     }
 
+    int getUniformLocation(const char* name) const{
+        return glGetUniformLocation(ID, name);
+    }
+
     void setBool(const std::string& name, bool value) const{
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
     }
@@ -145,6 +149,10 @@ public:
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
 
+    void setMat4(int location, const glm::mat4& mat) const{
+        glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+    }
+
 private:
     void checkCompileErrors(GLuint shader, std::string type){
         GLint success;
@@ -0,0 +1,153 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Game rules with no GL state attached. Everything the simulation reads or
+// writes lives in these plain structs, so a tick can be saved, restored and
+// replayed with a memcpy, and two peers seeded alike stay in lockstep.
+
+const int PIPE_COUNT = 8;
+const int RACE_PLAYERS = 2;
+const float SIM_DELTA = 0.002f;
+const float SIM_GAME_SPEED = 0.4f;
+const float BIRD_FLOOR = -0.77f;
+const float BIRD_CEILING = 0.9f;
+const unsigned int FLAP_TICKS = 25;
+
+struct WorldState {
+    glm::vec3 bgCurPos;
+    glm::vec3 pipeCurPos[PIPE_COUNT];
+    uint32_t rng;
+};
+
+struct BirdState {
+    glm::vec3 pos;
+    unsigned int flyUpCount;
+    float fallPoint;
+    unsigned int score, currentPipe;
+};
+
+struct RaceState {
+    WorldState world;
+    BirdState birds[RACE_PLAYERS];
+    bool crashed[RACE_PLAYERS];
+    uint32_t frame;
+};
+
+inline uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+inline void resetWorld(WorldState& world, uint32_t seed) {
+    world.bgCurPos = glm::vec3(0.0f);
+    for (int i = 0; i < PIPE_COUNT; i++)
+        world.pipeCurPos[i] = glm::vec3(1.5f + 0.5f * i, 0.0f, 0.0f);
+    world.rng = seed ? seed : 0x9E3779B9u;
+}
+
+inline void resetBird(BirdState& bird) {
+    bird.pos = glm::vec3(0.0f);
+    bird.flyUpCount = 0;
+    bird.fallPoint = 0.0f;
+    bird.score = 0;
+    bird.currentPipe = 0;
+}
+
+inline void resetRace(RaceState& race, uint32_t seed) {
+    resetWorld(race.world, seed);
+    for (int i = 0; i < RACE_PLAYERS; i++) {
+        resetBird(race.birds[i]);
+        race.crashed[i] = false;
+    }
+    race.frame = 0;
+}
+
+inline void flap(BirdState& bird) {
+    bird.fallPoint = bird.pos.y;
+    bird.flyUpCount += FLAP_TICKS;
+}
+
+inline void stepWorld(WorldState& world, float deltaTime) {
+    if (world.bgCurPos.x <= -4.0f)
+        world.bgCurPos.x = 0.0f;
+    world.bgCurPos.x -= SIM_GAME_SPEED * deltaTime;
+
+    for (auto& curPos : world.pipeCurPos) {
+        if (curPos.x <= -2.5f)
+            curPos.x = 1.5f;
+        if (curPos.x >= 1.5f && curPos.x <= 1.55f)
+            curPos.y = (nextRandom(world.rng) % 50 + 50) / 100.0f;
+        curPos.x -= SIM_GAME_SPEED * deltaTime;
+    }
+}
+
+inline void stepBird(BirdState& bird, float deltaTime) {
+    if (bird.flyUpCount == 0) {
+        bird.pos.y = glm::max(bird.pos.y - deltaTime, BIRD_FLOOR);
+    }
+    else {
+        bird.pos.y = glm::min(bird.pos.y + 5 * deltaTime, BIRD_CEILING);
+        bird.flyUpCount--;
+        if (bird.pos.y == BIRD_CEILING)
+            bird.flyUpCount = 0;
+    }
+}
+
+// Scores any pipe the bird has cleared and reports whether it hit one.
+inline bool checkCollision(BirdState& bird, const WorldState& world) {
+    float by = bird.pos.y;
+    for (int i = 0; i < PIPE_COUNT; i++) {
+        float px = world.pipeCurPos[i].x;
+        float py = world.pipeCurPos[i].y;
+        if (bird.currentPipe % PIPE_COUNT == (unsigned int)i && px < -0.1f && px > -1.0f) {
+            bird.score++;
+            bird.currentPipe++;
+        }
+        if (std::abs(px) > 0.1f)
+            continue;
+        if (by + py < 0.6f || by + py > 0.9f)
+            return true;
+    }
+    return false;
+}
+
+// Advances a single player one tick; returns true when the bird has crashed.
+inline bool stepPlaying(WorldState& world, BirdState& bird, float deltaTime) {
+    stepWorld(world, deltaTime);
+    stepBird(bird, deltaTime);
+    return bird.pos.y <= BIRD_FLOOR || checkCollision(bird, world);
+}
+
+// Both birds share one pipe course. A crashed bird drops to the floor while
+// the other keeps racing.
+inline void stepRace(RaceState& race, const uint8_t inputs[RACE_PLAYERS]) {
+    stepWorld(race.world, SIM_DELTA);
+    for (int i = 0; i < RACE_PLAYERS; i++) {
+        BirdState& bird = race.birds[i];
+        if (race.crashed[i]) {
+            bird.pos.y = glm::max(bird.pos.y - 1.5f * SIM_DELTA, BIRD_FLOOR);
+            continue;
+        }
+        if (inputs[i])
+            flap(bird);
+        stepBird(bird, SIM_DELTA);
+        race.crashed[i] = bird.pos.y <= BIRD_FLOOR || checkCollision(bird, race.world);
+    }
+    race.frame++;
+}
+
+inline bool raceFinished(const RaceState& race) {
+    for (int i = 0; i < RACE_PLAYERS; i++)
+        if (!race.crashed[i])
+            return false;
+    return true;
+}
+
+#endif
@@ -0,0 +1,453 @@
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include <renderer.h>
+#include <workerPool.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_SSE2 1
+#endif
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+const int SOFTWARE_TILE_ROWS = 16;
+const int SOFTWARE_MAX_WIDTH = 4096;
+const std::size_t SOFTWARE_COMMAND_RESERVE = 1024;
+
+// Pixels are RGBA bytes packed into little-endian words, so red is the low
+// byte. dst = src * a + dst * (1 - a), rounded like GL's 8-bit blending.
+inline uint32_t blendPixel(uint32_t dst, uint32_t src) {
+    uint32_t a = src >> 24;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t x = ((src >> shift) & 255) * a + ((dst >> shift) & 255) * (255 - a) + 128;
+        out |= ((x + (x >> 8)) >> 8) << shift;
+    }
+    return out;
+}
+
+inline void blendSpan(uint32_t* dst, const uint32_t* src, int count) {
+    int i = 0;
+#ifdef SOFTWARE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i div255 = _mm_set1_epi16(257);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+
+        __m128i sLo = _mm_unpacklo_epi8(s, zero), sHi = _mm_unpackhi_epi8(s, zero);
+        __m128i dLo = _mm_unpacklo_epi8(d, zero), dHi = _mm_unpackhi_epi8(d, zero);
+        __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, 0xFF), 0xFF);
+        __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, 0xFF), 0xFF);
+
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(sLo, aLo), _mm_mullo_epi16(dLo, _mm_sub_epi16(full, aLo))), half);
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(sHi, aHi), _mm_mullo_epi16(dHi, _mm_sub_epi16(full, aHi))), half);
+        lo = _mm_mulhi_epu16(lo, div255);
+        hi = _mm_mulhi_epu16(hi, div255);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; i++)
+        dst[i] = blendPixel(dst[i], src[i]);
+}
+
+// The post effects in 8-bit fixed point: mixes toward luma by gray/256,
+// then scales by shade/256. Alpha comes out opaque.
+inline uint32_t shadePixel(uint32_t pixel, uint32_t gray, uint32_t shade) {
+    uint32_t luma = (77 * (pixel & 255) + 150 * ((pixel >> 8) & 255) + 29 * ((pixel >> 16) & 255) + 128) >> 8;
+    uint32_t out = 0xFF000000u;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t c = (((pixel >> shift) & 255) * (256 - gray) + luma * gray + 128) >> 8;
+        out |= ((c * shade + 128) >> 8) << shift;
+    }
+    return out;
+}
+
+// Per pixel shade = base - vignette * edge / 255, where edges holds the
+// vignette's smoothstep for each pixel scaled to 255.
+inline uint32_t vignetteShade(uint32_t base, uint32_t vignette, uint32_t edge) {
+    return base - (((vignette * edge + 128) * 257) >> 16);
+}
+
+#ifdef SOFTWARE_SSE2
+// shadePixel for two pixels widened to 16-bit lanes, with the shade already
+// spread over each pixel's lanes.
+inline __m128i shadePair(__m128i px, __m128i shade, __m128i keep, __m128i mix) {
+    const __m128i weights = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+    const __m128i half = _mm_set1_epi16(128);
+    __m128i sums = _mm_madd_epi16(px, weights);
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128i luma = _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8);
+    luma = _mm_shufflehi_epi16(_mm_shufflelo_epi16(luma, 0), 0);
+    px = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(px, keep), _mm_mullo_epi16(luma, mix)), half), 8);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(px, shade), half), 8);
+}
+#endif
+
+inline void shadeSpan(uint32_t* dst, const uint8_t* edges, int count, uint32_t gray, uint32_t base, uint32_t vignette) {
+    int i = 0;
+#ifdef SOFTWARE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i div255 = _mm_set1_epi16(257);
+    const __m128i keep = _mm_set1_epi16((short)(256 - gray));
+    const __m128i mix = _mm_set1_epi16((short)gray);
+    const __m128i baseShade = _mm_set1_epi16((short)base);
+    const __m128i vignetteScale = _mm_set1_epi16((short)vignette);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    for (; i + 4 <= count; i += 4) {
+        int edgeBytes;
+        std::memcpy(&edgeBytes, edges + i, 4);
+        __m128i e = _mm_unpacklo_epi8(_mm_cvtsi32_si128(edgeBytes), zero);
+        __m128i shade = _mm_sub_epi16(baseShade, _mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(e, vignetteScale), half), div255));
+        shade = _mm_unpacklo_epi16(shade, shade);
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = shadePair(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(shade, shade), keep, mix);
+        __m128i hi = shadePair(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(shade, shade), keep, mix);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+#endif
+    for (; i < count; i++)
+        dst[i] = shadePixel(dst[i], gray, vignetteShade(base, vignette, edges[i]));
+}
+
+// Rasterizes into a framebuffer in memory, so the game can run and be
+// captured without a GPU. Draws are only recorded until present(); then the
+// framebuffer is split into bands of SOFTWARE_TILE_ROWS rows that worker
+// threads take one at a time, each band replaying every command clipped to
+// its rows. Bands never overlap, so no locking is needed while drawing and
+// draw order is kept within each band. Sampling is nearest-texel, and
+// blending and the post effects go four pixels at a time with SSE2 where
+// available.
+class SoftwareRenderer : public Renderer {
+    struct Image {
+        std::vector<uint32_t> pixels;
+        int width = 0, height = 0;
+    };
+
+    struct Glyph {
+        std::vector<uint8_t> coverage;
+        int width = 0, height = 0, left = 0, top = 0;
+        float advance = 0.0f;
+    };
+
+    struct Font {
+        FT_Face face;
+        bool loaded = false;
+        float pixelScale = 1.0f;
+        std::unordered_map<char32_t, Glyph> glyphs;
+    };
+
+    // A sprite samples RGBA texels; a glyph samples coverage and takes its
+    // color from the command.
+    struct Command {
+        const uint32_t* texels;
+        const uint8_t* coverage;
+        int texWidth, texHeight;
+        int x0, y0, x1, y1;
+        float left, top, texelsPerPixelX, texelsPerPixelY;
+        bool flipV;
+        uint32_t color;
+    };
+
+    int width, height, bandCount;
+    std::vector<uint32_t> framebuffer;
+    std::vector<uint8_t> vignetteEdges;
+    uint32_t clearColor;
+    float effects[POST_EFFECT_COUNT];
+    FrameSink* sink;
+
+    std::vector<Image> images;
+    FT_Library ft;
+    bool ftLoaded;
+    std::vector<std::unique_ptr<Font>> fonts;
+    std::vector<Command> commands;
+
+    std::atomic<int> nextBand;
+    WorkerPool pool;
+
+    static uint32_t packColor(const glm::vec3& color, uint32_t alpha) {
+        uint32_t r = (uint32_t)std::lround(std::min(std::max(color.x, 0.0f), 1.0f) * 255.0f);
+        uint32_t g = (uint32_t)std::lround(std::min(std::max(color.y, 0.0f), 1.0f) * 255.0f);
+        uint32_t b = (uint32_t)std::lround(std::min(std::max(color.z, 0.0f), 1.0f) * 255.0f);
+        return r | (g << 8) | (b << 16) | (alpha << 24);
+    }
+
+    const Glyph& glyph(Font& font, char32_t codepoint) {
+        auto it = font.glyphs.find(codepoint);
+        if (it != font.glyphs.end())
+            return it->second;
+
+        Glyph& g = font.glyphs[codepoint];
+        if (!font.loaded || FT_Load_Char(font.face, codepoint, FT_LOAD_RENDER)) {
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            return g;
+        }
+        FT_GlyphSlot slot = font.face->glyph;
+        g.width = (int)slot->bitmap.width;
+        g.height = (int)slot->bitmap.rows;
+        g.left = slot->bitmap_left;
+        g.top = slot->bitmap_top;
+        g.advance = (float)(slot->advance.x >> 6);
+        g.coverage.resize(g.width * g.height);
+        for (int row = 0; row < g.height; row++) {
+            const unsigned char* src = slot->bitmap.buffer + row * slot->bitmap.pitch;
+            std::copy(src, src + g.width, g.coverage.begin() + row * g.width);
+        }
+        return g;
+    }
+
+    // Records a textured rectangle given in framebuffer pixels.
+    void record(const uint32_t* texels, const uint8_t* coverage, int texWidth, int texHeight,
+                float left, float top, float right, float bottom, bool flipV, uint32_t color) {
+        if (texWidth <= 0 || texHeight <= 0 || right <= left || bottom <= top)
+            return;
+        Command c;
+        c.x0 = std::max((int)std::ceil(left - 0.5f), 0);
+        c.x1 = std::min((int)std::ceil(right - 0.5f), width);
+        c.y0 = std::max((int)std::ceil(top - 0.5f), 0);
+        c.y1 = std::min((int)std::ceil(bottom - 0.5f), height);
+        if (c.x0 >= c.x1 || c.y0 >= c.y1)
+            return;
+        c.texels = texels;
+        c.coverage = coverage;
+        c.texWidth = texWidth;
+        c.texHeight = texHeight;
+        c.left = left;
+        c.top = top;
+        c.texelsPerPixelX = texWidth / (right - left);
+        c.texelsPerPixelY = texHeight / (bottom - top);
+        c.flipV = flipV;
+        c.color = color;
+        commands.push_back(c);
+    }
+
+    void drawCommand(const Command& c, int y0, int y1, uint32_t* span) {
+        y0 = std::max(y0, c.y0);
+        y1 = std::min(y1, c.y1);
+        int count = c.x1 - c.x0;
+        uint32_t u0 = (uint32_t)((c.x0 + 0.5f - c.left) * c.texelsPerPixelX * 65536.0f);
+        uint32_t du = (uint32_t)(c.texelsPerPixelX * 65536.0f);
+        int maxU = c.texWidth - 1;
+
+        for (int y = y0; y < y1; y++) {
+            int ty = std::min((int)((y + 0.5f - c.top) * c.texelsPerPixelY), c.texHeight - 1);
+            if (c.flipV)
+                ty = c.texHeight - 1 - ty;
+
+            uint32_t u = u0;
+            if (c.texels) {
+                const uint32_t* row = c.texels + ty * c.texWidth;
+                for (int i = 0; i < count; i++, u += du)
+                    span[i] = row[std::min((int)(u >> 16), maxU)];
+            }
+            else {
+                const uint8_t* row = c.coverage + ty * c.texWidth;
+                for (int i = 0; i < count; i++, u += du)
+                    span[i] = c.color | ((uint32_t)row[std::min((int)(u >> 16), maxU)] << 24);
+            }
+            blendSpan(framebuffer.data() + y * width + c.x0, span, count);
+        }
+    }
+
+    // The vignette shader's smoothstep for every pixel, scaled to 255. The
+    // framebuffer never changes size, so this is built once.
+    void buildVignette() {
+        vignetteEdges.resize(width * height);
+        for (int y = 0; y < height; y++) {
+            float dy = (y + 0.5f) / height - 0.5f;
+            for (int x = 0; x < width; x++) {
+                float dx = (x + 0.5f) / width - 0.5f;
+                float t = std::min(std::max((std::sqrt(dx * dx + dy * dy) - 0.35f) / 0.5f, 0.0f), 1.0f);
+                vignetteEdges[y * width + x] = (uint8_t)std::lround(t * t * (3.0f - 2.0f * t) * 255.0f);
+            }
+        }
+    }
+
+    // Same math as the grayscale, vignette and fade shaders, in pass order,
+    // with the amounts folded into 8-bit fixed point once per band.
+    void applyEffects(int y0, int y1) {
+        float gray = effects[POST_GRAYSCALE], vignette = effects[POST_VIGNETTE], fade = effects[POST_FADE];
+        if (gray <= 0.0f && vignette <= 0.0f && fade <= 0.0f)
+            return;
+        uint32_t grayAmount = (uint32_t)std::lround(gray * 256.0f);
+        uint32_t base = (uint32_t)std::lround((1.0f - fade) * 256.0f);
+        uint32_t vignetteAmount = (uint32_t)std::lround(0.7f * vignette * (1.0f - fade) * 256.0f);
+        for (int y = y0; y < y1; y++)
+            shadeSpan(framebuffer.data() + y * width, vignetteEdges.data() + y * width, width, grayAmount, base, vignetteAmount);
+    }
+
+    void renderBands() {
+        alignas(16) uint32_t span[SOFTWARE_MAX_WIDTH];
+        int band;
+        while ((band = nextBand.fetch_add(1, std::memory_order_relaxed)) < bandCount) {
+            int y0 = band * SOFTWARE_TILE_ROWS;
+            int y1 = std::min(y0 + SOFTWARE_TILE_ROWS, height);
+            std::fill(framebuffer.begin() + y0 * width, framebuffer.begin() + y1 * width, clearColor);
+            for (const Command& c : commands)
+                if (c.y0 < y1 && c.y1 > y0)
+                    drawCommand(c, y0, y1, span);
+            applyEffects(y0, y1);
+        }
+    }
+
+    public:
+        // threads counts the calling thread; 0 uses every hardware thread.
+        SoftwareRenderer(int width, int height, FrameSink* sink = nullptr, unsigned int threads = 0)
+            : width(std::min(std::max(width, 1), SOFTWARE_MAX_WIDTH)), height(std::max(height, 1)), clearColor(0xFF000000u), sink(sink),
+              nextBand(0), pool(threads) {
+            bandCount = (this->height + SOFTWARE_TILE_ROWS - 1) / SOFTWARE_TILE_ROWS;
+            framebuffer.assign(this->width * this->height, clearColor);
+            buildVignette();
+            std::fill(effects, effects + POST_EFFECT_COUNT, 0.0f);
+            commands.reserve(SOFTWARE_COMMAND_RESERVE);
+
+            ftLoaded = !FT_Init_FreeType(&ft);
+            if (!ftLoaded)
+                std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        }
+
+        SoftwareRenderer(const SoftwareRenderer&) = delete;
+        SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+        ~SoftwareRenderer() {
+            for (auto& font : fonts)
+                if (font->loaded)
+                    FT_Done_Face(font->face);
+            if (ftLoaded)
+                FT_Done_FreeType(ft);
+        }
+
+        unsigned int loadTexture(const char* path) override {
+            Image image;
+            stbi_set_flip_vertically_on_load(false);
+            int channels;
+            unsigned char* data = stbi_load(path, &image.width, &image.height, &channels, 4);
+            if (data) {
+                image.pixels.resize(image.width * image.height);
+                for (std::size_t i = 0; i < image.pixels.size(); i++)
+                    image.pixels[i] = data[4 * i] | (data[4 * i + 1] << 8) | (data[4 * i + 2] << 16) | ((uint32_t)data[4 * i + 3] << 24);
+                stbi_image_free(data);
+            }
+            else {
+                std::cout << "Texture failed to load at path: " << path << std::endl;
+                image.width = image.height = 0;
+            }
+            images.push_back(std::move(image));
+            return (unsigned int)images.size() - 1;
+        }
+
+        // Fonts are rasterized at the framebuffer's scale so glyphs are
+        // sampled roughly one texel per pixel.
+        int loadFont(const char* path, int pixelSize) override {
+            std::unique_ptr<Font> font(new Font());
+            if (ftLoaded && !FT_New_Face(ft, path, 0, &font->face)) {
+                font->loaded = true;
+                int scaledSize = std::max((int)std::lround(pixelSize * (float)height / SCR_HEIGHT), 1);
+                FT_Set_Pixel_Sizes(font->face, scaledSize, 0);
+            }
+            else {
+                std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            }
+            fonts.push_back(std::move(font));
+            return (int)fonts.size() - 1;
+        }
+
+        void setEffect(int effect, float amount) override {
+            effects[effect] = std::min(std::max(amount, 0.0f), 1.0f);
+        }
+
+        // The framebuffer keeps its size; the sink scales it to the window.
+        void resize(int, int) override {}
+
+        void clear(const glm::vec3& color) override {
+            clearColor = packColor(color, 255);
+            commands.clear();
+        }
+
+        void drawSprite(unsigned int texture, const glm::vec2& min, const glm::vec2& max, bool flipV = false) override {
+            if (texture >= images.size())
+                return;
+            const Image& image = images[texture];
+            record(image.pixels.data(), nullptr, image.width, image.height,
+                   (min.x + 1.0f) * 0.5f * width, (1.0f - max.y) * 0.5f * height,
+                   (max.x + 1.0f) * 0.5f * width, (1.0f - min.y) * 0.5f * height, flipV, 0);
+        }
+
+        void drawText(int font, std::string_view text, float x, float y, float scale, const glm::vec3& color) override {
+            Font& f = *fonts[font];
+            float sx = (float)width / SCR_WIDTH;
+            float penX = x * sx;
+            float baseline = (SCR_HEIGHT - y) * (float)height / SCR_HEIGHT;
+            uint32_t rgb = packColor(color, 0);
+
+            const char* c = text.data();
+            const char* end = c + text.size();
+            while (c < end) {
+                const Glyph& g = glyph(f, decodeUtf8(c, end));
+                float left = penX + g.left * scale;
+                float top = baseline - g.top * scale;
+                record(nullptr, g.coverage.data(), g.width, g.height,
+                       left, top, left + g.width * scale, top + g.height * scale, false, rgb);
+                penX += g.advance * scale;
+            }
+        }
+
+        void present() override {
+            nextBand.store(0, std::memory_order_relaxed);
+            pool.run([this](int) { renderBands(); });
+            if (sink)
+                sink->show(framebuffer.data(), width, height);
+        }
+
+        double workerCpuSeconds() const override {
+            return pool.cpuSeconds();
+        }
+
+        const uint32_t* pixels() const {
+            return framebuffer.data();
+        }
+
+        int getWidth() const {
+            return width;
+        }
+
+        int getHeight() const {
+            return height;
+        }
+
+        // Writes the last presented frame as a binary PPM.
+        bool saveScreenshot(const char* path) const {
+            FILE* file = fopen(path, "wb");
+            if (!file) {
+                std::cout << "ERROR::SOFTWARE_RENDERER: Failed to open " << path << std::endl;
+                return false;
+            }
+            fprintf(file, "P6\n%d %d\n255\n", width, height);
+            for (uint32_t pixel : framebuffer) {
+                unsigned char rgb[3] = { (unsigned char)pixel, (unsigned char)(pixel >> 8), (unsigned char)(pixel >> 16) };
+                fwrite(rgb, 1, 3, file);
+            }
+            fclose(file);
+            return true;
+        }
+};
+
+#endif
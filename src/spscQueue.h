@@ -0,0 +1,42 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer/single-consumer ring. push() and pop() never block
+// or allocate, so the frame thread can hand work to a background thread.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    std::array<T, Capacity> buffer;
+    alignas(64) std::atomic<std::size_t> head{ 0 };
+    alignas(64) std::atomic<std::size_t> tail{ 0 };
+
+    public:
+        bool push(const T& item) {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == Capacity)
+                return false;
+            buffer[t & (Capacity - 1)] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& item) {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire))
+                return false;
+            item = buffer[h & (Capacity - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+};
+
+#endif
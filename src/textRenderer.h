@@ -1,10 +1,15 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <shader.h>
+#include <renderer.h>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -17,80 +22,205 @@
 #include FT_FREETYPE_H
 
 struct Character {
-    unsigned int TextureID;  
-    glm::ivec2   Size;       
-    glm::ivec2   Bearing;   
-    unsigned int Advance;  
+    glm::vec2    UvMin;
+    glm::vec2    UvMax;
+    glm::ivec2   Size;
+    glm::ivec2   Bearing;
+    unsigned int Advance;
+    int          Slot;
 };
 
-const unsigned int SCR_WIDTH = 1920;
-const unsigned int SCR_HEIGHT = 1080;
+const int GLYPH_PAGE_CELLS = 8;
+const int MAX_BATCH_GLYPHS = 128;
+
+// Glyphs of one font face, rasterized by FreeType the first time they are
+// drawn and packed into fixed-size cells of a single GPU texture page of
+// GLYPH_PAGE_CELLS x GLYPH_PAGE_CELLS cells, which covers the text this game
+// draws. When the page is full the least recently drawn glyph gives up its
+// cell.
+class GlyphCache {
+    struct Slot {
+        char32_t codepoint;
+        unsigned long long lastUsed;
+        bool used;
+    };
 
-class TextRenderer {
     FT_Library ft;
     FT_Face face;
-    Shader shader;
-    std::map<char, Character> Characters;
-    unsigned int VAO, VBO;
-    
-	public:
-        TextRenderer(std::string fontPath, std::string vertexShader, std::string fragmentShader, int fontHeight, int fontWidth = 0) {
-            
+    bool loaded;
+    int cellSize, columns, pageSize;
+    std::vector<Slot> slots;
+    std::unordered_map<char32_t, Character> glyphs;
+    const Character* ascii[128];
+    std::vector<unsigned char> cellPixels;
+
+    const Character& insert(char32_t codepoint, const Character& ch) {
+        const Character& entry = glyphs.emplace(codepoint, ch).first->second;
+        if (codepoint < 128)
+            ascii[codepoint] = &entry;
+        return entry;
+    }
+
+    public:
+        unsigned int texture;
+        unsigned long long stamp;
+
+        GlyphCache(const std::string& fontPath, int fontHeight, int fontWidth) : loaded(false), texture(0), stamp(1) {
+            std::fill(ascii, ascii + 128, nullptr);
             if (FT_Init_FreeType(&ft)) {
                 std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+                return;
             }
 
             if (FT_New_Face(ft, fontPath.c_str(), 0, &face)){
                 std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+                FT_Done_FreeType(ft);
+                return;
             }
+            loaded = true;
 
             FT_Set_Pixel_Sizes(face, fontWidth, fontHeight);
 
+            int lineHeight = (int)((face->size->metrics.ascender - face->size->metrics.descender) >> 6);
+            int maxAdvance = (int)(face->size->metrics.max_advance >> 6);
+            cellSize = std::max(lineHeight, maxAdvance) + 2;
+            columns = GLYPH_PAGE_CELLS;
+            pageSize = columns * cellSize;
+            slots.assign(columns * columns, Slot{ 0, 0, false });
+            cellPixels.resize(cellSize * cellSize);
+            glyphs.reserve(slots.size());
+
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            
-            shader = *(new Shader(vertexShader.c_str(), fragmentShader.c_str()));
-            glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
-            shader.use();
-            glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            // Left undefined: each cell is fully written before it is sampled.
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, pageSize, pageSize, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        GlyphCache(const GlyphCache&) = delete;
+        GlyphCache& operator=(const GlyphCache&) = delete;
+
+        ~GlyphCache() {
+            if (loaded) {
+                FT_Done_Face(face);
+                FT_Done_FreeType(ft);
+            }
+        }
+
+        // Returns the cached glyph and marks it as drawn in the current batch,
+        // or nullptr if it has not been rasterized yet.
+        const Character* find(char32_t codepoint) {
+            const Character* ch;
+            if (codepoint < 128) {
+                ch = ascii[codepoint];
+            }
+            else {
+                auto it = glyphs.find(codepoint);
+                ch = it == glyphs.end() ? nullptr : &it->second;
+            }
+            if (ch && ch->Slot >= 0)
+                slots[ch->Slot].lastUsed = stamp;
+            return ch;
+        }
+
+        int nextVictim() const {
+            int victim = 0;
+            for (int i = 0; i < (int)slots.size(); i++) {
+                if (!slots[i].used)
+                    return i;
+                if (slots[i].lastUsed < slots[victim].lastUsed)
+                    victim = i;
+            }
+            return victim;
+        }
+
+        // True if loading another glyph would overwrite a cell already queued
+        // for drawing, in which case the batch has to be flushed first.
+        bool victimInBatch() const {
+            if (slots.empty())
+                return false;
+            int victim = nextVictim();
+            return slots[victim].used && slots[victim].lastUsed == stamp;
+        }
 
-            for (unsigned char c = 0; c < 128; c++){
+        const Character& load(char32_t codepoint) {
+            Character ch = { glm::vec2(0.0f), glm::vec2(0.0f), glm::ivec2(0, 0), glm::ivec2(0, 0), 0, -1 };
+            if (!loaded || FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) {
+                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+                return insert(codepoint, ch);
+            }
 
-                if (FT_Load_Char(face, c, FT_LOAD_RENDER)){
-                    std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                    continue;
+            FT_GlyphSlot g = face->glyph;
+            ch.Size = glm::ivec2(g->bitmap.width, g->bitmap.rows);
+            ch.Bearing = glm::ivec2(g->bitmap_left, g->bitmap_top);
+            ch.Advance = (unsigned int)g->advance.x;
+
+            if (ch.Size.x > 0 && ch.Size.y > 0) {
+                int slot = nextVictim();
+                if (slots[slot].used) {
+                    glyphs.erase(slots[slot].codepoint);
+                    if (slots[slot].codepoint < 128)
+                        ascii[slots[slot].codepoint] = nullptr;
+                }
+                slots[slot] = Slot{ codepoint, stamp, true };
+
+                int w = std::min(ch.Size.x, cellSize - 2);
+                int h = std::min(ch.Size.y, cellSize - 2);
+                std::fill(cellPixels.begin(), cellPixels.end(), 0);
+                for (int row = 0; row < h; row++) {
+                    const unsigned char* src = g->bitmap.buffer + row * g->bitmap.pitch;
+                    std::copy(src, src + w, cellPixels.begin() + (row + 1) * cellSize + 1);
                 }
 
-                unsigned int texture;
-                glGenTextures(1, &texture);
+                int x0 = (slot % columns) * cellSize;
+                int y0 = (slot / columns) * cellSize;
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
                 glBindTexture(GL_TEXTURE_2D, texture);
-                glTexImage2D(
-                    GL_TEXTURE_2D,
-                    0,
-                    GL_RED,
-                    face->glyph->bitmap.width,
-                    face->glyph->bitmap.rows,
-                    0,
-                    GL_RED,
-                    GL_UNSIGNED_BYTE,
-                    face->glyph->bitmap.buffer
-                );
-
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-                Character character = {
-                    texture,
-                    glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                    glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                    face->glyph->advance.x
-                };
-                Characters.insert(std::pair<char, Character>(c, character));
+                glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, cellSize, cellSize, GL_RED, GL_UNSIGNED_BYTE, cellPixels.data());
+
+                ch.Slot = slot;
+                ch.Size = glm::ivec2(w, h);
+                ch.UvMin = glm::vec2((x0 + 1) / (float)pageSize, (y0 + 1) / (float)pageSize);
+                ch.UvMax = glm::vec2((x0 + 1 + w) / (float)pageSize, (y0 + 1 + h) / (float)pageSize);
             }
+            return insert(codepoint, ch);
+        }
+};
+
+class TextRenderer {
+    std::shared_ptr<GlyphCache> cache;
+    Shader shader;
+    int textColorLocation;
+    unsigned int VAO, VBO;
+    float batch[MAX_BATCH_GLYPHS][6][4];
+    int batchGlyphs;
+
+    void flush() {
+        if (batchGlyphs > 0) {
+            glBindTexture(GL_TEXTURE_2D, cache->texture);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(batch[0]) * batchGlyphs, batch);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDrawArrays(GL_TRIANGLES, 0, 6 * batchGlyphs);
+            batchGlyphs = 0;
+        }
+        cache->stamp++;
+    }
 
-            FT_Done_Face(face);
-            FT_Done_FreeType(ft);
+	public:
+        TextRenderer(std::string fontPath, std::string vertexShader, std::string fragmentShader, int fontHeight, int fontWidth = 0) : batchGlyphs(0) {
+            cache = std::make_shared<GlyphCache>(fontPath, fontHeight, fontWidth);
+
+            shader = *(new Shader(vertexShader.c_str(), fragmentShader.c_str()));
+            glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
+            shader.use();
+            glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            textColorLocation = shader.getUniformLocation("textColor");
 
             glEnable(GL_BLEND);
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -99,7 +229,7 @@ class TextRenderer {
             glGenBuffers(1, &VBO);
             glBindVertexArray(VAO);
             glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(batch), NULL, GL_DYNAMIC_DRAW);
             glEnableVertexAttribArray(0);
             glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -107,59 +237,64 @@ class TextRenderer {
         }
 
         TextRenderer(const TextRenderer& cp) {
-            this->ft = cp.ft;
-            this->face = cp.face;
+            this->cache = cp.cache;
             this->shader = cp.shader;
-            this->Characters = cp.Characters;
+            this->textColorLocation = cp.textColorLocation;
             this->VAO = cp.VAO;
             this->VBO = cp.VBO;
+            this->batchGlyphs = 0;
         }
 
-        TextRenderer() {};
-        
-        void RenderText(std::string text, float x, float y, float scale, glm::vec3 color){
+        TextRenderer() : batchGlyphs(0) {};
+
+        // text is UTF-8; glyphs are rasterized on first use.
+        void RenderText(std::string_view text, float x, float y, float scale, glm::vec3 color){
 
             this->shader.use();
-            glUniform3f(glGetUniformLocation(this->shader.ID, "textColor"), color.x, color.y, color.z);
+            glUniform3f(textColorLocation, color.x, color.y, color.z);
             glActiveTexture(GL_TEXTURE0);
             glBindVertexArray(VAO);
 
-            std::string::const_iterator c;
-            for (c = text.begin(); c != text.end(); c++){
-                Character ch = Characters[*c];
-
-                float xpos = x + ch.Bearing.x * scale;
-                float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-                float w = ch.Size.x * scale;
-                float h = ch.Size.y * scale;
-
-
-                float vertices[6][4] = {
-                    { xpos,     ypos + h,   0.0f, 0.0f },
-                    { xpos,     ypos,       0.0f, 1.0f },
-                    { xpos + w, ypos,       1.0f, 1.0f },
-
-                    { xpos,     ypos + h,   0.0f, 0.0f },
-                    { xpos + w, ypos,       1.0f, 1.0f },
-                    { xpos + w, ypos + h,   1.0f, 0.0f }
-                };
-
-                glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-
-                glBindBuffer(GL_ARRAY_BUFFER, VBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+            const char* c = text.data();
+            const char* end = c + text.size();
+            while (c < end){
+                char32_t codepoint = decodeUtf8(c, end);
+                const Character* found = cache->find(codepoint);
+                if (!found) {
+                    if (cache->victimInBatch())
+                        flush();
+                    found = &cache->load(codepoint);
+                }
+                const Character& ch = *found;
+
+                if (ch.Slot >= 0) {
+                    float xpos = x + ch.Bearing.x * scale;
+                    float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+
+                    float w = ch.Size.x * scale;
+                    float h = ch.Size.y * scale;
+
+                    float vertices[6][4] = {
+                        { xpos,     ypos + h,   ch.UvMin.x, ch.UvMin.y },
+                        { xpos,     ypos,       ch.UvMin.x, ch.UvMax.y },
+                        { xpos + w, ypos,       ch.UvMax.x, ch.UvMax.y },
+
+                        { xpos,     ypos + h,   ch.UvMin.x, ch.UvMin.y },
+                        { xpos + w, ypos,       ch.UvMax.x, ch.UvMax.y },
+                        { xpos + w, ypos + h,   ch.UvMax.x, ch.UvMin.y }
+                    };
+                    std::copy(&vertices[0][0], &vertices[0][0] + 24, &batch[batchGlyphs][0][0]);
+                    if (++batchGlyphs == MAX_BATCH_GLYPHS)
+                        flush();
+                }
 
-                x += (ch.Advance >> 6) * scale; 
+                x += (ch.Advance >> 6) * scale;
             }
+            flush();
             glBindVertexArray(0);
             glBindTexture(GL_TEXTURE_2D, 0);
         }
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,102 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+const std::size_t MAX_PACKET_SIZE = 64;
+
+struct Packet {
+    uint8_t data[MAX_PACKET_SIZE];
+    std::size_t size;
+};
+
+// Unreliable, unordered datagram channel between two peers.
+class Transport {
+    public:
+        virtual ~Transport() {}
+        virtual void send(const Packet& packet) = 0;
+        virtual bool receive(Packet& packet) = 0;
+};
+
+struct LinkConditions {
+    float delayMs = 0.0f;
+    float jitterMs = 0.0f;
+    float lossRate = 0.0f;
+    uint32_t seed = 1;
+};
+
+// In-process stand-in for a UDP socket pair. Every packet is held back by
+// delayMs plus up to jitterMs and dropped with probability lossRate, so
+// rollback behaviour can be exercised without a real network.
+class LoopbackTransport : public Transport {
+    struct InFlight {
+        std::chrono::steady_clock::time_point deliverAt;
+        Packet packet;
+    };
+
+    struct Channel {
+        std::mutex lock;
+        std::vector<InFlight> packets;
+    };
+
+    std::shared_ptr<Channel> outgoing, incoming;
+    LinkConditions conditions;
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+    LoopbackTransport(std::shared_ptr<Channel> outgoing, std::shared_ptr<Channel> incoming, const LinkConditions& conditions)
+        : outgoing(outgoing), incoming(incoming), conditions(conditions), rng(conditions.seed) {
+        this->outgoing->packets.reserve(256);
+    }
+
+    public:
+        static void createPair(const LinkConditions& conditions, std::unique_ptr<LoopbackTransport>& a, std::unique_ptr<LoopbackTransport>& b) {
+            auto ab = std::make_shared<Channel>();
+            auto ba = std::make_shared<Channel>();
+            LinkConditions other = conditions;
+            other.seed = conditions.seed * 2654435761u + 1;
+            a.reset(new LoopbackTransport(ab, ba, conditions));
+            b.reset(new LoopbackTransport(ba, ab, other));
+        }
+
+        void setConditions(const LinkConditions& conditions) {
+            this->conditions = conditions;
+        }
+
+        void send(const Packet& packet) override {
+            if (unit(rng) < conditions.lossRate)
+                return;
+            float delay = conditions.delayMs + conditions.jitterMs * unit(rng);
+            InFlight entry;
+            entry.deliverAt = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(delay * 1000.0f));
+            entry.packet = packet;
+
+            std::lock_guard<std::mutex> guard(outgoing->lock);
+            outgoing->packets.push_back(entry);
+        }
+
+        bool receive(Packet& packet) override {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> guard(incoming->lock);
+            auto& packets = incoming->packets;
+            std::size_t due = packets.size();
+            for (std::size_t i = 0; i < packets.size(); i++) {
+                if (packets[i].deliverAt <= now && (due == packets.size() || packets[i].deliverAt < packets[due].deliverAt))
+                    due = i;
+            }
+            if (due == packets.size())
+                return false;
+            packet = packets[due].packet;
+            packets[due] = packets.back();
+            packets.pop_back();
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <cpuTime.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that, together with the caller, run one job at a
+// time. run() hands the same job to every thread and returns once all of them
+// are done; the job splits the work itself, by thread index or by taking
+// items from a shared counter. Jobs are a function pointer and a context, so
+// dispatching one never allocates. The workers' CPU time on jobs is summed so
+// callers can charge it to whatever the jobs were for.
+class WorkerPool {
+    typedef void (*Job)(void* context, int thread);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    Job job;
+    void* context;
+    double workerCpu;
+    unsigned long long generation;
+    int busyWorkers;
+    bool quitting;
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quitting = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    void workerLoop(int thread) {
+        unsigned long long seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return quitting || generation != seen; });
+            if (quitting)
+                return;
+            seen = generation;
+            lock.unlock();
+            double start = threadCpuSeconds();
+            job(context, thread);
+            double cpu = threadCpuSeconds() - start;
+            lock.lock();
+            workerCpu += cpu;
+            if (--busyWorkers == 0)
+                done.notify_one();
+        }
+    }
+
+    public:
+        // threads counts the calling thread; 0 uses every hardware thread.
+        explicit WorkerPool(unsigned int threads) : job(nullptr), context(nullptr), workerCpu(0.0), generation(0), busyWorkers(0), quitting(false) {
+            if (threads == 0)
+                threads = std::max(std::thread::hardware_concurrency(), 1u);
+            // Threads already started must be joined if a later one fails.
+            try {
+                for (unsigned int i = 1; i < threads; i++)
+                    workers.emplace_back(&WorkerPool::workerLoop, this, (int)i);
+            }
+            catch (...) {
+                stop();
+                throw;
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        ~WorkerPool() {
+            stop();
+        }
+
+        int size() const {
+            return (int)workers.size() + 1;
+        }
+
+        // CPU seconds the workers, not the caller, have spent on jobs. Read
+        // it between runs.
+        double cpuSeconds() const {
+            return workerCpu;
+        }
+
+        // Runs job(context, thread) once on every thread; the caller is thread 0.
+        void run(Job job, void* context) {
+            if (workers.empty()) {
+                job(context, 0);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                this->job = job;
+                this->context = context;
+                busyWorkers = (int)workers.size();
+                generation++;
+            }
+            wake.notify_all();
+            job(context, 0);
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return busyWorkers == 0; });
+        }
+
+        // Same, for any callable taking the thread index; it is only
+        // referenced, never copied.
+        template <typename Fn>
+        void run(const Fn& fn) {
+            run([](void* context, int thread) { (*(const Fn*)context)(thread); }, (void*)&fn);
+        }
+};
+
+#endif